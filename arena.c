@@ -0,0 +1,57 @@
+/*
+ * arena.c
+ * bump allocator over EWRAM - allocating just moves a pointer along, and
+ * everything after a mark is freed at once by going back to it, which the
+ * scenes do each time they change
+ */
+
+#include <stddef.h>
+#include "arena.h"
+
+/* the next free byte, and the furthest it has been */
+static unsigned int top = ARENA_START;
+static unsigned int highest = ARENA_START;
+
+/* empty the whole arena */
+void arena_init( ) {
+    top = ARENA_START;
+    highest = ARENA_START;
+}
+
+/* take size bytes, returns NULL if there is not that much left - the
+ * profiler keeps the number of bytes in use */
+void* arena_alloc(unsigned int size) {
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (size > ARENA_END - top) {
+        return NULL;
+    }
+    void* memory = (void*) top;
+    top += size;
+    if (top > highest) {
+        highest = top;
+    }
+    profile_value(PROFILE_ARENA, top - ARENA_START);
+    return memory;
+}
+
+/* where the arena is up to, to go back to later */
+unsigned int arena_mark( ) {
+    return top;
+}
+
+/* free everything allocated since a mark was taken */
+void arena_reset(unsigned int mark) {
+    if (mark >= ARENA_START && mark <= top) {
+        top = mark;
+    }
+}
+
+/* the bytes in use now */
+unsigned int arena_used( ) {
+    return top - ARENA_START;
+}
+
+/* the most bytes there have been in use */
+unsigned int arena_peak( ) {
+    return highest - ARENA_START;
+}
@@ -0,0 +1,36 @@
+/*
+ * arena.h
+ * bump allocator over EWRAM - allocating just moves a pointer along, and
+ * everything after a mark is freed at once by going back to it, which the
+ * scenes do each time they change
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "profile.h"
+
+/* EWRAM is 256K, the arena has all of it up to the profiler's debug area */
+#define ARENA_START 0x2000000
+#define ARENA_END PROFILE_DEBUG_ADDRESS
+
+/* every allocation starts on a word, so it can be copied with DMA */
+#define ARENA_ALIGN 4
+
+/* empty the whole arena */
+void arena_init( );
+
+/* take size bytes, returns NULL if there is not that much left */
+void* arena_alloc(unsigned int size);
+
+/* where the arena is up to, to go back to later */
+unsigned int arena_mark( );
+
+/* free everything allocated since a mark was taken */
+void arena_reset(unsigned int mark);
+
+/* the bytes in use now, and the most there have been */
+unsigned int arena_used( );
+unsigned int arena_peak( );
+
+#endif
@@ -0,0 +1,244 @@
+/*
+ * bench.c
+ * program which times the assembly routines against C doing the same job,
+ * and shows the cycles each one takes per element on screen - it is built
+ * on its own, not with the game:
+ *     ./gbacc bench.c profile.c uppercase_ref.c uppercase.s wallLeft.s irq.c irq_dispatch.s \
+ *         pak.c pak_bin.s vram.c
+ *
+ * the sizes and number of runs can be changed through gbacc's CFLAGS:
+ *     CFLAGS="-DBENCH_SIZES=1,8,512 -DBENCH_RUNS=4" ./gbacc bench.c ...
+ */
+
+#include <ctype.h>
+
+/* the font, from the pak */
+#include "pak.h"
+
+/* cycle counts from timers 2 and 3 */
+#include "profile.h"
+
+/* the routines being timed */
+#include "uppercase.h"
+int wallLeft(int curX, int origX, int leftX);
+
+/* the display control register and the flags for one tile layer */
+volatile unsigned long* display_control = (volatile unsigned long*) 0x4000000;
+#define MODE0 0x00
+#define BG0_ENABLE 0x100
+
+/* background 0 shows the text, from char block 3, where the pak puts the
+ * font, and screen block 31 */
+volatile unsigned short* bg0_control = (volatile unsigned short*) 0x4000008;
+volatile unsigned short* text_map = (volatile unsigned short*) 0x600f800;
+
+/* the numbers of elements each routine is timed over, and how many times
+ * it is run for each, the cycles are added up over the runs */
+#ifndef BENCH_SIZES
+#define BENCH_SIZES 10, 64, 256
+#endif
+#ifndef BENCH_RUNS
+#define BENCH_RUNS 16
+#endif
+#define BENCH_MAX_SIZE 1024
+
+/* the results, hundredths of a cycle per element in the order they are
+ * shown, where a debugger or emulator script can read them too */
+#define BENCH_MAX 32
+unsigned int bench_results[BENCH_MAX];
+int bench_count = 0;
+
+/* the text the string routines work on, and a copy to put it back from */
+char text[BENCH_MAX_SIZE + 4] __attribute__((aligned(4)));
+char text_source[BENCH_MAX_SIZE + 4];
+
+/* the walls the wall routines move, and where they go back to */
+int wall_x[BENCH_MAX_SIZE];
+int wall_origin[BENCH_MAX_SIZE];
+
+/* load the font and clear the screen */
+void setup_text( ) {
+    pak_init();
+    pak_load(PAK_BACKGROUNDS_PALETTE);
+    pak_load(PAK_BACKGROUND_DATA);
+    for (int i = 0; i < 32 * 32; i++) {
+        text_map[i] = 0;
+    }
+    *bg0_control = 0 | (3 << 2) | (1 << 7) | (31 << 8);
+}
+
+/* put a string on the screen, the font starts at the space character */
+void set_text(const char* str, int row, int col) {
+    int index = row * 32 + col;
+    while (*str) {
+        text_map[index++] = *str++ - 32;
+    }
+}
+
+/* write a number of hundredths as a decimal, right aligned in 7 places */
+void hundredths_text(char* str, unsigned int value) {
+    str[7] = 0;
+    for (int i = 6; i >= 0; i--) {
+        if (i == 4) {
+            str[i] = '.';
+        } else if (value || i >= 3) {
+            str[i] = '0' + value % 10;
+            value /= 10;
+        } else {
+            str[i] = ' ';
+        }
+    }
+}
+
+/* write a whole number right aligned in 4 places */
+void count_text(char* str, unsigned int value) {
+    str[4] = 0;
+    for (int i = 3; i >= 0; i--) {
+        str[i] = (value || i == 3) ? '0' + value % 10 : ' ';
+        value /= 10;
+    }
+}
+
+/* show a result on the next line and keep it - the name, the number of
+ * elements each run worked on and the cycles per element - the screen has
+ * room for 18 of them */
+void report(const char* name, int size, unsigned int cycles) {
+    unsigned int hundredths = (cycles * 100) / (size * BENCH_RUNS);
+    if (bench_count < BENCH_MAX) {
+        bench_results[bench_count] = hundredths;
+    }
+    int row = 2 + bench_count++;
+    if (row < 20) {
+        char number[8];
+        set_text(name, row, 1);
+        count_text(number, size);
+        set_text(number, row, 14);
+        hundredths_text(number, hundredths);
+        set_text(number, row, 21);
+    }
+}
+
+/* the way uppercase.s used to work, calling into the C library each byte */
+void uppercase_toupper(char* s) {
+    for (; *s; s++) {
+        *s = toupper(*s);
+    }
+}
+
+/* the same as wallLeft.s, which replaced a C wall_left in main.c until the
+ * walls were put in the world and left to the camera */
+int wall_left_c(int x, int origin, int left) {
+    return (x <= left) ? origin : x - 1;
+}
+
+/* time one string routine over the text, putting it back before each run */
+unsigned int time_string(void (*routine)(char*), int length) {
+    unsigned int total = 0;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        for (int i = 0; i < length; i++) {
+            text[i] = text_source[i];
+        }
+        text[length] = 0;
+
+        unsigned int start = profile_now();
+        routine(text);
+        total += profile_now() - start;
+    }
+    return total;
+}
+
+/* the walls go back once they are off the left of the screen */
+#define WALL_LEFT -16
+
+/* put the walls spread across the screen, so a few go back each run */
+void reset_walls(int count) {
+    for (int i = 0; i < count; i++) {
+        wall_x[i] = ((i * 7) & 0xff) + WALL_LEFT;
+        wall_origin[i] = 240;
+    }
+}
+
+/* time one wall routine moving every wall along once a run - both go
+ * through a pointer, so the call costs the same */
+unsigned int time_wall(int (*routine)(int, int, int), int count) {
+    unsigned int total = 0;
+    reset_walls(count);
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        unsigned int start = profile_now();
+        for (int i = 0; i < count; i++) {
+            wall_x[i] = routine(wall_x[i], wall_origin[i], WALL_LEFT);
+        }
+        total += profile_now() - start;
+    }
+    return total;
+}
+
+/* the C version again, where the compiler can put it in the loop, which the
+ * assembly can never have */
+unsigned int time_wall_inline(int count) {
+    unsigned int total = 0;
+    reset_walls(count);
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        unsigned int start = profile_now();
+        for (int i = 0; i < count; i++) {
+            wall_x[i] = (wall_x[i] <= WALL_LEFT) ? wall_origin[i] : wall_x[i] - 1;
+        }
+        total += profile_now() - start;
+    }
+    return total;
+}
+
+/* run every routine over each size, returns whether the assembly and C
+ * versions all gave the same results */
+int run_benchmarks( ) {
+    static const int sizes[] = {BENCH_SIZES};
+    int same = 1;
+
+    for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        int size = sizes[i];
+        if (size < 1 || size > BENCH_MAX_SIZE) {
+            continue;
+        }
+
+        /* each assembly routine's results are kept to check the C against */
+        static char text_check[BENCH_MAX_SIZE + 4];
+        report("UPPER ASM", size, time_string(uppercase, size));
+        for (int j = 0; j <= size; j++) {
+            text_check[j] = text[j];
+        }
+        report("UPPER C", size, time_string(uppercase_reference, size));
+        for (int j = 0; j <= size; j++) {
+            same &= (text_check[j] == text[j]);
+        }
+        report("UPPER LIBC", size, time_string(uppercase_toupper, size));
+
+        static int wall_check[BENCH_MAX_SIZE];
+        report("WALL ASM", size, time_wall(wallLeft, size));
+        for (int j = 0; j < size; j++) {
+            wall_check[j] = wall_x[j];
+        }
+        report("WALL C", size, time_wall(wall_left_c, size));
+        for (int j = 0; j < size; j++) {
+            same &= (wall_check[j] == wall_x[j]);
+        }
+        report("WALL INLINE", size, time_wall_inline(size));
+    }
+    return same;
+}
+
+int main( ) {
+    *display_control = MODE0 | BG0_ENABLE;
+    setup_text();
+    profile_init();
+    set_text("CYCLES PER ELEMENT", 0, 1);
+
+    /* mixed case text with some punctuation, like the screens have */
+    static const char sample[] = "Helicopter High Score 1234, press Start! ";
+    for (int i = 0; i < BENCH_MAX_SIZE; i++) {
+        text_source[i] = sample[i % (sizeof(sample) - 1)];
+    }
+
+    set_text(run_benchmarks() ? "SAME" : "DIFF", 0, 24);
+
+    while (1) { }
+}
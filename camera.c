@@ -0,0 +1,72 @@
+/*
+ * camera.c
+ * the view of the world, a 32-bit fixed point position with 8 bits below
+ * the pixel - the scroll registers, where sprites go on the screen and when
+ * new parts of the world are brought in are all worked out from it
+ */
+
+#include "camera.h"
+
+/* the world wraps at 2^24 pixels, which is all a 32-bit position holds */
+#define CAMERA_PIXEL_MASK 0xffffff
+
+/* put the camera at the start of the world, moving at a speed */
+void camera_init(struct Camera* camera, int speed) {
+    camera->x = 0;
+    camera->y = 0;
+    camera->speed = speed;
+    camera->last_x = 0;
+}
+
+/* move the camera along for one frame, wrapping at the end of the world */
+void camera_update(struct Camera* camera) {
+    camera->last_x = camera->x;
+    camera->x += camera->speed;
+}
+
+/* the whole pixels travelled from the start of the world */
+unsigned int camera_pixel_x(const struct Camera* camera) {
+    return camera->x >> CAMERA_SHIFT;
+}
+
+unsigned int camera_pixel_y(const struct Camera* camera) {
+    return camera->y >> CAMERA_SHIFT;
+}
+
+/* the value for a background's scroll registers, which only hold 9 bits */
+unsigned short camera_scroll_x(const struct Camera* camera) {
+    return camera_pixel_x(camera) & 0x1ff;
+}
+
+unsigned short camera_scroll_y(const struct Camera* camera) {
+    return camera_pixel_y(camera) & 0x1ff;
+}
+
+/* the distance between two pixel positions, taking the shorter way round
+ * the world, so one just past the wrap is still just ahead */
+static int camera_distance(unsigned int from, unsigned int to) {
+    int distance = (to - from) & CAMERA_PIXEL_MASK;
+    if (distance > CAMERA_PIXEL_MASK / 2) {
+        distance -= CAMERA_PIXEL_MASK + 1;
+    }
+    return distance;
+}
+
+/* where a world pixel position is on the screen, negative to the left of
+ * or above it */
+int camera_screen_x(const struct Camera* camera, unsigned int world_x) {
+    return camera_distance(camera_pixel_x(camera), world_x);
+}
+
+int camera_screen_y(const struct Camera* camera, unsigned int world_y) {
+    return camera_distance(camera_pixel_y(camera), world_y);
+}
+
+/* how many times the last move crossed a multiple of 2^shift pixels - the
+ * difference wraps like the positions do, so it is sign extended from the
+ * bits the positions have at that shift */
+int camera_crossed(const struct Camera* camera, int shift) {
+    shift += CAMERA_SHIFT;
+    unsigned int crossed = (camera->x >> shift) - (camera->last_x >> shift);
+    return (int) (crossed << shift) >> shift;
+}
@@ -0,0 +1,52 @@
+/*
+ * camera.h
+ * the view of the world, a 32-bit fixed point position with 8 bits below
+ * the pixel - the scroll registers, where sprites go on the screen and when
+ * new parts of the world are brought in are all worked out from it
+ */
+
+#ifndef CAMERA_H
+#define CAMERA_H
+
+/* positions and speeds are in 256ths of a pixel */
+#define CAMERA_SHIFT 8
+#define CAMERA_ONE (1 << CAMERA_SHIFT)
+
+/* the camera, the world coordinates of the top left of the screen - the
+ * world is 16 million pixels across before it wraps, and a difference of
+ * two positions is right even across the wrap */
+struct Camera {
+    unsigned int x;
+    unsigned int y;
+
+    /* how far it moves right each frame */
+    int speed;
+
+    /* where it was before the last move */
+    unsigned int last_x;
+};
+
+/* put the camera at the start of the world, moving at a speed */
+void camera_init(struct Camera* camera, int speed);
+
+/* move the camera along for one frame */
+void camera_update(struct Camera* camera);
+
+/* the whole pixels travelled from the start of the world */
+unsigned int camera_pixel_x(const struct Camera* camera);
+unsigned int camera_pixel_y(const struct Camera* camera);
+
+/* the value for a background's scroll registers, which only hold 9 bits */
+unsigned short camera_scroll_x(const struct Camera* camera);
+unsigned short camera_scroll_y(const struct Camera* camera);
+
+/* where a world pixel position is on the screen, negative to the left of
+ * or above it */
+int camera_screen_x(const struct Camera* camera, unsigned int world_x);
+int camera_screen_y(const struct Camera* camera, unsigned int world_y);
+
+/* how many times the last move crossed a multiple of 2^shift pixels, like
+ * a column of tiles with a shift of 3 - negative if it moved left */
+int camera_crossed(const struct Camera* camera, int shift);
+
+#endif
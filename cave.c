@@ -0,0 +1,121 @@
+/*
+ * cave.c
+ * procedural cave generator which produces the ceiling, floor and obstacle
+ * columns of the course one tile column at a time
+ */
+
+#include "cave.h"
+
+/* the fewest rows of rock the ceiling and floor ever have */
+#define CAVE_WALL_MIN 3
+
+/* the gap starts wide open and narrows by a row every so many columns */
+#define CAVE_GAP_START 14
+#define CAVE_GAP_MIN 7
+#define CAVE_NARROW_SHIFT 6
+
+/* obstacles are small blocks of rock floating in the gap */
+#define CAVE_OBSTACLE_WIDTH 2
+#define CAVE_OBSTACLE_HEIGHT 3
+#define CAVE_OBSTACLE_WAIT 16
+
+/* a mask with a bit set for every row of the cave */
+#define CAVE_ALL_ROWS ((1 << CAVE_ROWS) - 1)
+
+/* set the generator up to start a new cave from a seed */
+void cave_init(struct Cave* cave, unsigned int seed) {
+    random_seed(&cave->random, seed);
+
+    /* start out level and wide open so the player can get going */
+    cave->ceiling = CAVE_WALL_MIN;
+    cave->gap = CAVE_GAP_START;
+    cave->drift = 0;
+    cave->column = 0;
+    cave->obstacle_wait = CAVE_OBSTACLE_WAIT * 2;
+    cave->obstacle_left = 0;
+    cave->obstacle_rows = 0;
+
+    for (int i = 0; i < CAVE_COLUMNS; i++) {
+        cave->solid[i] = 0;
+    }
+}
+
+/* generate the next column and write it into the screen block map - the
+ * work done is the same for every column so it is safe to call in a frame */
+void cave_next_column(struct Cave* cave, volatile unsigned short* map, unsigned short tile) {
+    unsigned int r = random_next(&cave->random);
+
+    /* narrow the gap as the course goes on */
+    int gap = CAVE_GAP_START - (cave->column >> CAVE_NARROW_SHIFT);
+    if (gap < CAVE_GAP_MIN) {
+        gap = CAVE_GAP_MIN;
+    }
+    cave->gap = gap;
+
+    /* now and then change the direction the gap drifts in */
+    if ((r & 7) == 0) {
+        cave->drift = (int) ((((r >> 3) & 0xff) * 3) >> 8) - 1;
+    }
+
+    /* every other column or so move the ceiling along the drift */
+    if (r & 0x100) {
+        cave->ceiling += cave->drift;
+    }
+
+    /* keep the ceiling and floor within bounds, bouncing off of them */
+    int lowest = CAVE_ROWS - CAVE_WALL_MIN - gap;
+    if (cave->ceiling < CAVE_WALL_MIN) {
+        cave->ceiling = CAVE_WALL_MIN;
+        cave->drift = 1;
+    }
+    if (cave->ceiling > lowest) {
+        cave->ceiling = lowest;
+        cave->drift = -1;
+    }
+
+    /* rock above the ceiling and below the floor */
+    unsigned int rows = ((1 << cave->ceiling) - 1) |
+        (CAVE_ALL_ROWS & ~((1 << (cave->ceiling + gap)) - 1));
+
+    /* start a new obstacle somewhere in the gap, leaving room to pass it */
+    if (cave->obstacle_left == 0 && --cave->obstacle_wait <= 0) {
+        int space = gap - CAVE_OBSTACLE_HEIGHT;
+        int top = cave->ceiling + 1 + random_range(&cave->random, space - 1);
+        cave->obstacle_rows = ((1 << CAVE_OBSTACLE_HEIGHT) - 1) << top;
+        cave->obstacle_left = CAVE_OBSTACLE_WIDTH;
+        cave->obstacle_wait = CAVE_OBSTACLE_WAIT + random_range(&cave->random, CAVE_OBSTACLE_WAIT);
+    }
+    if (cave->obstacle_left > 0) {
+        rows |= cave->obstacle_rows;
+        cave->obstacle_left--;
+    }
+
+    /* store the column in the collision map */
+    int slot = cave->column & (CAVE_COLUMNS - 1);
+    cave->solid[slot] = rows;
+    cave->column++;
+
+    /* and write it into the tile map */
+    for (int row = 0; row < CAVE_ROWS; row++) {
+        map[row * CAVE_COLUMNS + slot] = (rows & 1) ? tile : 0;
+        rows >>= 1;
+    }
+}
+
+/* returns whether the world pixel position x, y is inside the rock */
+int cave_solid(struct Cave* cave, int x, int y) {
+    int column = x >> 3;
+    int row = y >> 3;
+
+    /* columns which have not been generated, or have been scrolled away */
+    if (column >= cave->column || column < cave->column - CAVE_COLUMNS) {
+        return 0;
+    }
+
+    /* everything above and below the cave is rock */
+    if (row < 0 || row >= CAVE_ROWS) {
+        return 1;
+    }
+
+    return (cave->solid[column & (CAVE_COLUMNS - 1)] >> row) & 1;
+}
@@ -0,0 +1,53 @@
+/*
+ * cave.h
+ * procedural cave generator which produces the ceiling, floor and obstacle
+ * columns of the course one tile column at a time
+ */
+
+#ifndef CAVE_H
+#define CAVE_H
+
+#include "random.h"
+
+/* the number of tile rows the cave covers (the height of the screen) */
+#define CAVE_ROWS 20
+
+/* the number of tile columns in the screen block we stream into, it wraps */
+#define CAVE_COLUMNS 32
+
+/* the generator state - the same seed always produces the same cave */
+struct Cave {
+    /* the cave has its own generator so nothing else disturbs the course */
+    struct Random random;
+
+    /* the number of rows of rock hanging from the top */
+    int ceiling;
+
+    /* the number of open rows between the ceiling and the floor */
+    int gap;
+
+    /* which way the gap is drifting, -1 up, 0 level, 1 down */
+    int drift;
+
+    /* the world column that will be generated next */
+    int column;
+
+    /* columns left until the next obstacle, and of the current one */
+    int obstacle_wait;
+    int obstacle_left;
+    unsigned int obstacle_rows;
+
+    /* the collision map, bit r of an entry is set if row r is rock */
+    unsigned int solid[CAVE_COLUMNS];
+};
+
+/* set the generator up to start a new cave from a seed */
+void cave_init(struct Cave* cave, unsigned int seed);
+
+/* generate the next column and write it into the screen block map */
+void cave_next_column(struct Cave* cave, volatile unsigned short* map, unsigned short tile);
+
+/* returns whether the world pixel position x, y is inside the rock */
+int cave_solid(struct Cave* cave, int x, int y);
+
+#endif
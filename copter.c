@@ -3,6 +3,9 @@
  * program which demonstraes tile mode 0
  */
 
+/* crt0's interrupt table is in irq.c, so this is built along with it:
+ *     ./gbacc copter.c irq.c irq_dispatch.s */
+
 /* include the image we are using */
 #include "HeliBack.h"
 
@@ -180,29 +183,3 @@ int main( ) {
     }
 }
 
-
-/* the game boy advance uses "interrupts" to handle certain situations
- * for now we will ignore these */
-void interrupt_ignore( ) {
-    /* do nothing */
-}
-
-
-/* this table specifies which interrupts we handle which way
- * for now, we ignore all of them */
-typedef void (*intrp)( );
-const intrp IntrTable[13] = {
-    interrupt_ignore,   /* V Blank interrupt */
-    interrupt_ignore,   /* H Blank interrupt */
-    interrupt_ignore,   /* V Counter interrupt */
-    interrupt_ignore,   /* Timer 0 interrupt */
-    interrupt_ignore,   /* Timer 1 interrupt */
-    interrupt_ignore,   /* Timer 2 interrupt */
-    interrupt_ignore,   /* Timer 3 interrupt */
-    interrupt_ignore,   /* Serial communication interrupt */
-    interrupt_ignore,   /* DMA 0 interrupt */
-    interrupt_ignore,   /* DMA 1 interrupt */
-    interrupt_ignore,   /* DMA 2 interrupt */
-    interrupt_ignore,   /* DMA 3 interrupt */
-    interrupt_ignore,   /* Key interrupt */
-};
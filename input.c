@@ -0,0 +1,91 @@
+/*
+ * input.c
+ * the buttons are read from the hardware once per frame into a snapshot,
+ * and every query that frame is answered from it with bit operations
+ */
+
+#include "input.h"
+
+#ifndef HOST_BUILD
+/* the button register holds the bits which indicate whether each button has
+ * been pressed - a bit is 0 while its button is held down */
+static volatile unsigned short* buttons = (volatile unsigned short*) 0x04000130;
+#else
+/* the recorded stream played back on the host */
+static const unsigned short* host_frames = 0;
+static int host_count = 0;
+#endif
+
+/* the buttons held this frame and last frame, 1 bits are held down */
+static unsigned short current = 0;
+static unsigned short previous = 0;
+
+/* the buttons which repeat this frame, and how long they have been held */
+static unsigned short repeated = 0;
+static int repeat_timer = 0;
+
+/* read the buttons for this frame, call it once at the start of each frame -
+ * sampling once a frame also debounces them, a bouncing contact can't
+ * change state more than once in 1/60th of a second */
+void input_update( ) {
+#ifndef HOST_BUILD
+    input_latch(~*buttons & BUTTON_ALL);
+#else
+    if (host_count > 0) {
+        input_latch(*host_frames++);
+        host_count--;
+    } else {
+        input_latch(0);
+    }
+#endif
+}
+
+/* use a snapshot of the buttons for this frame instead of the hardware */
+void input_latch(unsigned short keys) {
+    previous = current;
+    current = keys & BUTTON_ALL;
+
+    /* a new press repeats right away, then after a delay, then steadily */
+    if (current != previous) {
+        repeat_timer = 0;
+        repeated = current & ~previous;
+    } else if (++repeat_timer >= INPUT_REPEAT_DELAY) {
+        repeat_timer -= INPUT_REPEAT_RATE;
+        repeated = current;
+    } else {
+        repeated = 0;
+    }
+}
+
+/* the buttons held down this frame */
+unsigned short input_keys( ) {
+    return current;
+}
+
+/* returns the buttons out of the mask which are held down this frame */
+unsigned short input_held(unsigned short mask) {
+    return current & mask;
+}
+
+/* returns the buttons out of the mask which went down this frame */
+unsigned short input_pressed(unsigned short mask) {
+    return current & ~previous & mask;
+}
+
+/* returns the buttons out of the mask which came up this frame */
+unsigned short input_released(unsigned short mask) {
+    return ~current & previous & mask;
+}
+
+/* like input_pressed, but also fires every few frames while held down */
+unsigned short input_repeat(unsigned short mask) {
+    return repeated & mask;
+}
+
+#ifdef HOST_BUILD
+/* on the host input_update plays back a recorded stream of snapshots */
+void input_host_play(const unsigned short* frames, int count) {
+    host_frames = frames;
+    host_count = count;
+}
+#endif
@@ -0,0 +1,59 @@
+/*
+ * input.h
+ * the buttons are read from the hardware once per frame into a snapshot,
+ * and every query that frame is answered from it with bit operations
+ */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+/* the bit positions indicate each button - the first bit is for A, second for
+ * B, and so on, each constant below can be ANDED into the register to get the
+ * status of any one button */
+#define BUTTON_A (1 << 0)
+#define BUTTON_B (1 << 1)
+#define BUTTON_SELECT (1 << 2)
+#define BUTTON_START (1 << 3)
+#define BUTTON_RIGHT (1 << 4)
+#define BUTTON_LEFT (1 << 5)
+#define BUTTON_UP (1 << 6)
+#define BUTTON_DOWN (1 << 7)
+#define BUTTON_R (1 << 8)
+#define BUTTON_L (1 << 9)
+
+/* all of the buttons together */
+#define BUTTON_ALL 0x03ff
+
+/* frames a button is held before it repeats, and frames between repeats */
+#define INPUT_REPEAT_DELAY 20
+#define INPUT_REPEAT_RATE 4
+
+/* read the buttons for this frame, call it once at the start of each frame */
+void input_update( );
+
+/* use a snapshot of the buttons for this frame instead of the hardware,
+ * with a 1 bit for each button held down */
+void input_latch(unsigned short keys);
+
+/* the buttons held down this frame */
+unsigned short input_keys( );
+
+/* returns the buttons out of the mask which are held down this frame */
+unsigned short input_held(unsigned short mask);
+
+/* returns the buttons out of the mask which went down this frame */
+unsigned short input_pressed(unsigned short mask);
+
+/* returns the buttons out of the mask which came up this frame */
+unsigned short input_released(unsigned short mask);
+
+/* like input_pressed, but also fires every few frames while held down */
+unsigned short input_repeat(unsigned short mask);
+
+#ifdef HOST_BUILD
+/* on the host input_update plays back a recorded stream of snapshots,
+ * and returns no buttons once it runs out */
+void input_host_play(const unsigned short* frames, int count);
+#endif
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * irq.c
+ * interrupt dispatcher, which runs the handler for the most important
+ * interrupt waiting and lets more important ones interrupt it in turn
+ */
+
+#include <stddef.h>
+#include "irq.h"
+
+/* the handlers in priority order, read by irq_dispatch in irq_dispatch.s -
+ * each has the bit of its interrupt and the bits of the ones allowed to
+ * interrupt its handler, and the list ends with an empty entry */
+struct IrqEntry {
+    unsigned short mask;
+    unsigned short nest;
+    irq_handler handler;
+};
+struct IrqEntry irq_entries[IRQ_COUNT + 1];
+
+/* the interrupts irq_set has enabled, and the ones the handler running now
+ * lets nest inside it, all of them when no handler is running - the enable
+ * register is always the two together, irq_dispatch narrows the second while
+ * a handler runs and puts it back after, so an interrupt enabled or disabled
+ * inside a handler stays that way */
+volatile unsigned short irq_enabled;
+volatile unsigned short irq_limit;
+
+/* the dispatcher itself is ARM code in IWRAM, too far away to branch to */
+void irq_dispatch( ) __attribute__((long_call));
+
+/* the handler and priority set for each interrupt */
+static irq_handler handlers[IRQ_COUNT];
+static int priorities[IRQ_COUNT];
+
+/* the BIOS calls the function this points to for any interrupt */
+static irq_handler volatile* irq_vector = (irq_handler volatile*) 0x3007ffc;
+
+/* the interrupt enable, flag and master registers */
+static volatile unsigned short* interrupt_enable = (volatile unsigned short*) 0x4000200;
+static volatile unsigned short* interrupt_flags = (volatile unsigned short*) 0x4000202;
+static volatile unsigned short* interrupt_master = (volatile unsigned short*) 0x4000208;
+
+/* the display status register, which has to ask for the display interrupts */
+static volatile unsigned short* display_status = (volatile unsigned short*) 0x4000004;
+static const unsigned short display_bits[IRQ_COUNT] = {0x0008, 0x0010, 0x0020};
+
+/* rebuild the list the dispatcher reads, with interrupts off - a stable
+ * selection sort, so equal priorities go in the order of their bits */
+static void irq_rebuild( ) {
+    int order[IRQ_COUNT];
+    int count = 0;
+    int done = 0;
+    while (1) {
+        int best = -1;
+        for (int i = 0; i < IRQ_COUNT; i++) {
+            if (handlers[i] && !(done & (1 << i)) &&
+                (best < 0 || priorities[i] > priorities[best])) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+
+        /* only strictly more important interrupts may nest inside this one */
+        unsigned short higher = 0;
+        for (int i = 0; i < count; i++) {
+            if (priorities[order[i]] > priorities[best]) {
+                higher |= 1 << order[i];
+            }
+        }
+        irq_entries[count].mask = 1 << best;
+        irq_entries[count].nest = higher;
+        irq_entries[count].handler = handlers[best];
+        order[count++] = best;
+        done |= 1 << best;
+    }
+    irq_entries[count].mask = 0;
+    irq_entries[count].nest = 0;
+    irq_entries[count].handler = NULL;
+}
+
+/* install the dispatcher in place of the one in crt0, with nothing enabled */
+void irq_init( ) {
+    *interrupt_master = 0;
+    irq_enabled = 0;
+    irq_limit = 0xffff;
+    *interrupt_enable = 0;
+    *interrupt_flags = 0xffff;
+    for (int i = 0; i < IRQ_COUNT; i++) {
+        handlers[i] = NULL;
+        priorities[i] = 0;
+    }
+    irq_rebuild();
+    *irq_vector = irq_dispatch;
+    *interrupt_master = 1;
+}
+
+/* set the handler for an interrupt and enable it - a higher priority one can
+ * interrupt a lower one's handler, equal ones wait their turn - interrupts
+ * are off while the tables change, then back to how they were */
+void irq_set(int irq, irq_handler handler, int priority) {
+    unsigned short master = *interrupt_master;
+    *interrupt_master = 0;
+    handlers[irq] = handler;
+    priorities[irq] = priority;
+    irq_rebuild();
+    *display_status |= display_bits[irq];
+    irq_enabled |= 1 << irq;
+    *interrupt_enable = irq_enabled & irq_limit;
+    *interrupt_master = master;
+}
+
+/* disable an interrupt and forget its handler, leaving interrupts on or off
+ * as they were */
+void irq_clear(int irq) {
+    unsigned short master = *interrupt_master;
+    *interrupt_master = 0;
+    irq_enabled &= ~(1 << irq);
+    *interrupt_enable = irq_enabled & irq_limit;
+    *display_status &= ~display_bits[irq];
+    handlers[irq] = NULL;
+    irq_rebuild();
+    *interrupt_master = master;
+}
+
+/* crt0 will not link without its own table of handlers, but irq_init takes
+ * over from the handler which reads it, so it only has to exist */
+static void irq_ignore( ) {
+}
+const irq_handler IntrTable[13] = {
+    irq_ignore, irq_ignore, irq_ignore, irq_ignore, irq_ignore, irq_ignore, irq_ignore,
+    irq_ignore, irq_ignore, irq_ignore, irq_ignore, irq_ignore, irq_ignore
+};
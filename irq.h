@@ -0,0 +1,49 @@
+/*
+ * irq.h
+ * interrupt dispatcher, which runs the handler for the most important
+ * interrupt waiting and lets more important ones interrupt it in turn
+ */
+
+#ifndef IRQ_H
+#define IRQ_H
+
+/* the interrupts, in the order of their bits in the enable and flag registers */
+enum Irq {
+    IRQ_VBLANK,
+    IRQ_HBLANK,
+    IRQ_VCOUNT,
+    IRQ_TIMER0,
+    IRQ_TIMER1,
+    IRQ_TIMER2,
+    IRQ_TIMER3,
+    IRQ_SERIAL,
+    IRQ_DMA0,
+    IRQ_DMA1,
+    IRQ_DMA2,
+    IRQ_DMA3,
+    IRQ_KEYPAD,
+    IRQ_CARTRIDGE,
+    IRQ_COUNT
+};
+
+/* a handler is a plain function, it does not need to acknowledge anything */
+typedef void (*irq_handler)( );
+
+/* install the dispatcher in place of the one in crt0, with nothing enabled */
+void irq_init( );
+
+/* set the handler for an interrupt and enable it - a higher priority one can
+ * interrupt a lower one's handler, equal ones wait their turn - each level of
+ * nesting takes 40 bytes of the 160 byte interrupt stack, so keep to three or
+ * four priorities, and turning on timer and DMA interrupts in their own
+ * control registers is left to whoever uses them - this leaves the interrupt
+ * master enable as it found it, and can be called from a handler, where an
+ * interrupt less important than the one being handled waits until it is done */
+void irq_set(int irq, irq_handler handler, int priority);
+
+/* disable an interrupt and forget its handler - like irq_set this leaves the
+ * interrupt master enable as it found it and can be called from a handler,
+ * the interrupt stays off once the handler returns */
+void irq_clear(int irq);
+
+#endif
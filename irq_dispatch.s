@@ -0,0 +1,100 @@
+@ irq_dispatch.s
+@ the interrupt handler the BIOS calls, this is ARM code in IWRAM since it
+@ runs on every interrupt and has to get to the handler as soon as it can
+    .section .iwram, "ax", %progbits
+    .arm
+    .align 2
+
+@ each entry of irq_entries in irq.c is the interrupt's bit in the low
+@ halfword, the bits allowed to nest inside it in the high one, then the
+@ handler - the list is in priority order and ends with a zero bit
+
+@ void irq_dispatch()
+@ the BIOS has already saved r0-r3, r12 and lr on the interrupt stack, and
+@ returns to the interrupted code when this returns
+    .global irq_dispatch
+irq_dispatch:
+    @ r3 points at the enable register, which has the flags just after it
+    mov r3, #0x04000000
+    add r3, r3, #0x200
+    ldr r2, [r3]
+    and r1, r2, r2, lsr #16
+
+    @ find the most important handler whose interrupt is waiting
+    ldr r12, =irq_entries
+.dispatchFind:
+    ldr r0, [r12], #8
+    movs r2, r0, lsl #16
+    beq .dispatchNone
+    tst r1, r2, lsr #16
+    beq .dispatchFind
+    ldr r12, [r12, #-4]
+
+    @ acknowledge it in the flags register and in the BIOS's copy, which
+    @ the BIOS interrupt wait functions look at
+    mov r2, r2, lsr #16
+    strh r2, [r3, #2]
+    ldr r1, =0x03007ff8
+    ldrh r3, [r1]
+    orr r3, r3, r2
+    strh r3, [r1]
+
+    @ keep the interrupts the interrupted code let nest, the interrupted
+    @ mode and where to return, which a nested interrupt would overwrite, on
+    @ the interrupt stack
+    mov r3, #0x04000000
+    add r3, r3, #0x200
+    ldr r1, =irq_limit
+    ldrh r1, [r1]
+    mrs r2, spsr
+    stmfd sp!, {r1-r3, lr}
+
+    @ only let in the interrupts more important than this one - the enable
+    @ register is always irq_enabled from irq.c narrowed by irq_limit, so
+    @ irq_set and irq_clear in the handler keep to this too
+    mov r0, r0, lsr #16
+    ldr r1, =irq_limit
+    strh r0, [r1]
+    ldr r1, =irq_enabled
+    ldrh r1, [r1]
+    and r1, r1, r0
+    strh r1, [r3]
+
+    @ run the handler in system mode with interrupts on, so they can nest,
+    @ keeping the interrupted code's lr which the call overwrites
+    mrs r1, cpsr
+    bic r1, r1, #0xdf
+    orr r1, r1, #0x1f
+    msr cpsr_c, r1
+    stmfd sp!, {lr}
+    mov lr, pc
+    bx r12
+    ldmfd sp!, {lr}
+
+    @ back to interrupt mode with interrupts off, and put everything back -
+    @ the enable register from what is enabled now rather than what was
+    @ enabled before, in case the handler enabled or disabled any
+    mrs r1, cpsr
+    bic r1, r1, #0xdf
+    orr r1, r1, #0x92
+    msr cpsr_c, r1
+    ldmfd sp!, {r1-r3, lr}
+    ldr r0, =irq_limit
+    strh r1, [r0]
+    ldr r0, =irq_enabled
+    ldrh r0, [r0]
+    and r0, r0, r1
+    strh r0, [r3]
+    msr spsr_cxsf, r2
+    bx lr
+
+.dispatchNone:
+    @ nothing handles these, so just acknowledge them
+    strh r1, [r3, #2]
+    ldr r2, =0x03007ff8
+    ldrh r0, [r2]
+    orr r0, r0, r1
+    strh r0, [r2]
+    bx lr
+
+    .pool
@@ -2,12 +2,58 @@
 #define SCREEN_HEIGHT 160
 
 #include <stdio.h>
-/* include the background image we are using */
-#include "realHeli.h"
-#include "background.h"
+/* the images, loaded from the pak in ROM when a scene needs them */
+#include "pak.h"
 
-/* include the sprite image we are using */
-#include "realCopter.h"
+/* the procedural cave the course is built from */
+#include "cave.h"
+
+/* the title, play, pause and game over states */
+#include "scene.h"
+
+/* high scores and settings kept in SRAM */
+#include "save.h"
+
+/* the buttons, read once per frame */
+#include "input.h"
+
+/* sound effects mixed into direct sound */
+#include "mixer.h"
+#include "sounds.h"
+
+/* music played on the sound chip, and the song made by tools/mus2gba */
+#include "psg.h"
+#include "theme_song.h"
+
+/* cycle counts for the frame and the mixer */
+#include "profile.h"
+
+/* the interrupt dispatcher */
+#include "irq.h"
+
+/* memory for buffers, freed a scene at a time */
+#include "arena.h"
+
+/* allocator for things the same size */
+#include "pool.h"
+
+/* upper casing text for the screen */
+#include "uppercase.h"
+
+/* sparks from crashes, drawn in the sprites the game leaves free */
+#include "particles.h"
+
+/* more sprites than OAM holds, rewritten down the screen */
+#include "mux.h"
+
+/* puts the sprites in depth order before they go to the multiplexer */
+#include "render.h"
+
+/* the view of the world, which scrolls along with the run */
+#include "camera.h"
+
+/* what is in each part of VRAM, checked in VRAM_CHECK builds */
+#include "vram.h"
 
 
 
@@ -16,6 +62,7 @@
 #define MODE1 0x01
 #define BG0_ENABLE 0x100
 #define BG1_ENABLE 0x200
+#define BG2_ENABLE 0x400
 
 /* flags to set sprite handling in display control register */
 #define SPRITE_MAP_2D 0x0
@@ -26,11 +73,12 @@
 /* the control registers for the four tile layers */
 volatile unsigned short* bg0_control = (volatile unsigned short*) 0x4000008;
 volatile unsigned short* bg1_control = (volatile unsigned short*) 0x400000a;
+volatile unsigned short* bg2_control = (volatile unsigned short*) 0x400000c;
 /* palette is always 256 colors */
 #define PALETTE_SIZE 256
 
-/* there are 128 sprites on the GBA */
-#define NUM_SPRITES 128
+/* there are 128 sprites on the GBA, but the multiplexer can show more */
+#define NUM_SPRITES MUX_MAX
 
 /* the display control pointer points to the gba graphics register */
 volatile unsigned long* display_control = (volatile unsigned long*) 0x4000000;
@@ -45,28 +93,14 @@ volatile unsigned short* sprite_image_memory = (volatile unsigned short*) 0x6010
 volatile unsigned short* bg_palette = (volatile unsigned short*) 0x5000000;
 volatile unsigned short* sprite_palette = (volatile unsigned short*) 0x5000200;
 
-/* the button register holds the bits which indicate whether each button has
- * been pressed - this has got to be volatile as well
- */
-volatile unsigned short* buttons = (volatile unsigned short*) 0x04000130;
+/* the blending registers, used to draw the ghost see through */
+volatile unsigned short* blend_control = (volatile unsigned short*) 0x4000050;
+volatile unsigned short* blend_alpha = (volatile unsigned short*) 0x4000052;
 
 /* scrolling registers for backgrounds */
 volatile short* bg0_x_scroll = (unsigned short*) 0x4000010;
 volatile short* bg0_y_scroll = (unsigned short*) 0x4000012;
-
-/* the bit positions indicate each button - the first bit is for A, second for
- * B, and so on, each constant below can be ANDED into the register to get the
- * status of any one button */
-#define BUTTON_A (1 << 0)
-#define BUTTON_B (1 << 1)
-#define BUTTON_SELECT (1 << 2)
-#define BUTTON_START (1 << 3)
-#define BUTTON_RIGHT (1 << 4)
-#define BUTTON_LEFT (1 << 5)
-#define BUTTON_UP (1 << 6)
-#define BUTTON_DOWN (1 << 7)
-#define BUTTON_R (1 << 8)
-#define BUTTON_L (1 << 9)
+volatile short* bg2_x_scroll = (unsigned short*) 0x4000018;
 
 /* the scanline counter is a memory cell which is updated to indicate how
  * much of the screen has been drawn */
@@ -78,19 +112,6 @@ void wait_vblank( ) {
     while (*scanline_counter < 160) { }
 }
 
-/* this function checks whether a particular button has been pressed */
-unsigned char button_pressed(unsigned short button) {
-    /* and the button register with the button constant we want */
-    unsigned short pressed = *buttons & button;
-
-    /* if this value is zero, then it's not pressed */
-    if (pressed == 0) {
-        return 1;
-    } else {
-        return 0;
-    }
-}
-
 /* return a pointer to one of the 4 character blocks (0-3) */
 volatile unsigned short* char_block(unsigned long block) {
     /* they are each 16K big */
@@ -128,14 +149,18 @@ void memcpy16_dma(unsigned short* dest, unsigned short* source, int amount) {
     *dma_count = amount | DMA_16 | DMA_ENABLE;
 }
 
+/* the tile index and palette color used for the rock of the cave */
+#define CAVE_TILE 96
+#define CAVE_COLOR 1
+
 /* function to setup background 0 for this program */
 void setup_background() {
 
-    /* load the palette from the image into palette memory*/
-    memcpy16_dma((unsigned short*) bg_palette, (unsigned short*) realHeli_palette, PALETTE_SIZE);
-
-    /* load the image into char block 0 */
-    memcpy16_dma((unsigned short*) char_block(0), (unsigned short*) realHeli_data, (realHeli_width * realHeli_height) / 2);
+    /* load the palette the image shares with the font into palette memory,
+     * once for both layers, and the image's different tiles into char
+     * block 0 */
+    pak_load(PAK_BACKGROUNDS_PALETTE);
+    pak_load(PAK_REALHELI_DATA);
 
     /* set all control the bits in this register */
     *bg0_control = 2 |    /* priority, 0 is highest, 3 is lowest */
@@ -145,10 +170,17 @@ void setup_background() {
         (30 << 8) |       /* the screen block the tile data is stored in */
         (1 << 13) |       /* wrapping flag */
         (0 << 14);        /* bg size, 0 is 256x256 */
-    
-    //memcpy16_dma((unsigned short*) bg_palette, (unsigned short*) background_palette, PALETTE_SIZE);
+    vram_claim_map(*bg0_control, "bg0 map");
+    vram_check_tiles(*bg0_control, "bg0 tiles");
+
+    /* the screen map of which tile goes where stays in ROM and is copied */
+    const unsigned short* map = pak_data(PAK_REALHELI_MAP, NULL);
+    memcpy16_dma((unsigned short*) screen_block(30), (unsigned short*) map, 32 * 32);
+}
 
-    memcpy16_dma((unsigned short*) char_block(3), (unsigned short*) background_data, (background_width * background_height) / 2);
+/* function to setup the text on background 1 */
+void setup_text() {
+    pak_load(PAK_BACKGROUND_DATA);
     *bg1_control = 1 |
         (3 << 2)  |
         (0 << 6)  |
@@ -156,17 +188,34 @@ void setup_background() {
         (31 << 8) |
         (1 << 13) |
         (0 << 14);
+    vram_claim_map(*bg1_control, "bg1 map");
+    vram_check_tiles(*bg1_control, "bg1 tiles");
 
-    unsigned short* background = screen_block(30);
-    for(int i = 0; i < 1024; i++){
-        background[i] = i;
-    }
-
-     background =  screen_block(31);
+    unsigned short* background =  screen_block(31);
        for(int i = 0; i < 32 * 32; i++){
            background[i] = 0;
        }
 }
+
+/* function to setup the cave tile on background 2 */
+void setup_cave() {
+    /* the cave goes on background 2, it shares char block 3 with the text
+     * and has one solid tile of its own after the 96 font tiles */
+    volatile unsigned short* rock = char_block(3) + (CAVE_TILE * 32);
+    for (int i = 0; i < 32; i++) {
+        rock[i] = (CAVE_COLOR << 8) | CAVE_COLOR;
+    }
+    vram_claim(3 * VRAM_CHAR_BLOCK_SIZE + CAVE_TILE * 64, 64, "rock tile");
+    *bg2_control = 1 |
+        (3 << 2)  |
+        (0 << 6)  |
+        (1 << 7)  |
+        (29 << 8) |
+        (1 << 13) |
+        (0 << 14);
+    vram_claim_map(*bg2_control, "bg2 map");
+    vram_check_tiles(*bg2_control, "bg2 tiles");
+}
 /* just kill time */
 void delay(unsigned int amount) {
     for (int i = 0; i < amount * 10; i++);
@@ -184,6 +233,20 @@ struct Sprite {
 struct Sprite sprites[NUM_SPRITES];
 int next_sprite_index = 0;
 
+/* how far back each sprite is drawn, nearer ones go in front whatever
+ * order they were set up in - the HUD would go in front of them all - this
+ * only holds for sprites starting in the same 32 line band of the mux, so a
+ * ghost at y 30 is still drawn over the copter at y 34 */
+#define DEPTH_HUD 0
+#define DEPTH_COPTER 32
+#define DEPTH_GHOST 48
+#define DEPTH_WALL 64
+#define DEPTH_PARTICLE 128
+unsigned char sprite_depths[NUM_SPRITES];
+
+/* the sprites in depth order, which is what the multiplexer is given */
+struct Sprite shadow_sprites[NUM_SPRITES];
+
 /* the different sizes of sprites which are possible */
 enum SpriteSize {
     SIZE_8_8,
@@ -200,12 +263,22 @@ enum SpriteSize {
     SIZE_32_64
 };
 
+/* the flag in attribute 0 which turns a sprite off, while it is not affine */
+#define SPRITE_HIDDEN 0x0200
+
+/* the size of a sprite in pixels, by its shape bits then its size bits */
+const unsigned char sprite_widths[3][4] = {{8, 16, 32, 64}, {16, 32, 32, 64}, {8, 8, 16, 32}};
+const unsigned char sprite_heights[3][4] = {{8, 16, 32, 64}, {8, 8, 16, 32}, {16, 32, 32, 64}};
+
+int sprite_position(struct Sprite* sprite, int x, int y);
+
 /* function to initialize a sprite with its properties, and return a pointer */
 struct Sprite* sprite_init(int x, int y, enum SpriteSize size,
     int horizontal_flip, int vertical_flip, int tile_index, int priority) {
 
     /* grab the next index */
     int index = next_sprite_index++;
+    sprite_depths[index] = DEPTH_WALL;   /* until it is changed */
 
     /* setup the bits used for each shape/size possible */
     int size_bits, shape_bits;
@@ -228,11 +301,11 @@ struct Sprite* sprite_init(int x, int y, enum SpriteSize size,
     int v = vertical_flip ? 1 : 0;
 
     /* set up the first attribute */
-    sprites[index].attribute0 = y |             /* y coordinate */
+    sprites[index].attribute0 = 0 |             /* y coordinate, set below */
                             (0 << 8) |          /*rendering mode */                                     (0 << 10) |         /* gfx mode */                                          (0 << 12) |         /* mosaic */
                             (1 << 13) |         /* color mode 0:16, 1:256 */                            (shape_bits << 14); /* shape */
     /* set up the second attribute */
-    sprites[index].attribute1 = x |             /* x coordinate */
+    sprites[index].attribute1 = 0 |             /* x coordinate, set below */
                             (0 << 9) |          /* affine flag */
                             (h << 12) |         /* horizontal flip flag */
                             (v << 13) |         /* vertical flip flag */
@@ -241,14 +314,33 @@ struct Sprite* sprite_init(int x, int y, enum SpriteSize size,
     sprites[index].attribute2 = tile_index |   // tile index */
                             (priority << 10) | // priority */
                             (0 << 12);         // palette bank (only 16 color)*/
+    /* put it where it goes, which hides it if that is off the screen */
+    sprite_position(&sprites[index], x, y);
+
     /* return pointer to this sprite */
     return &sprites[index];
 }
 
-/* update all of the spries on the screen */
-void sprite_update_all() {
-    /* copy them all over */
-    memcpy16_dma((unsigned short*) sprite_attribute_memory, (unsigned short*) sprites, NUM_SPRITES * 4);
+/* change how far back a sprite is drawn */
+void sprite_set_depth(struct Sprite* sprite, int depth) {
+    sprite_depths[sprite - sprites] = depth;
+}
+
+/* put the first count sprites in depth order, with anything past the ones
+ * set up being particles, and hand them to the multiplexer, which puts them
+ * into OAM from the next vblank on */
+void sprite_update_all(int count) {
+    render_begin();
+    for (int i = 0; i < count; i++) {
+        /* hidden sprites cost nothing past here */
+        if (sprites[i].attribute0 & SPRITE_HIDDEN) {
+            continue;
+        }
+        render_add((unsigned short*) &sprites[i],
+                   i < next_sprite_index ? sprite_depths[i] : DEPTH_PARTICLE);
+    }
+    count = render_end((unsigned short*) shadow_sprites);
+    mux_frame((unsigned short*) shadow_sprites, count);
 }
 
 /* setup all sprites */
@@ -256,35 +348,61 @@ void sprite_clear() {
     /* clear the index counter */
     next_sprite_index = 0;
 
-    /* move all sprites offscreen to hide them */
+    /* the particles are drawn after the game's sprites, so they go too */
+    particles_clear();
+
+    /* hide all the sprites */
     for(int i = 0; i < NUM_SPRITES; i++) {
-        sprites[i].attribute0 = SCREEN_HEIGHT;
-        sprites[i].attribute1 = SCREEN_WIDTH;
+        sprites[i].attribute0 = SPRITE_HIDDEN;
+        sprites[i].attribute1 = 0;
         }
 }
 
-/* set a sprite postion */
-void sprite_position(struct Sprite* sprite, int x, int y) {
-    /* clear out the y coordinate */
-    sprite->attribute0 &= 0xff00;
+/* hide a sprite until it is next given a position on the screen */
+void sprite_hide(struct Sprite* sprite) {
+    sprite->attribute0 |= SPRITE_HIDDEN;
+}
+
+/* set a sprite postion, which can be off any edge of the screen - OAM only
+ * has 9 bits of x and 8 of y, so a sprite with none of it on the screen is
+ * hidden rather than wrapped round to the other side, returns whether it is
+ * showing */
+int sprite_position(struct Sprite* sprite, int x, int y) {
+    int shape = sprite->attribute0 >> 14;
+    int size = sprite->attribute1 >> 14;
+    if (x <= -sprite_widths[shape][size] || x >= SCREEN_WIDTH ||
+        y <= -sprite_heights[shape][size] || y >= SCREEN_HEIGHT) {
+        sprite_hide(sprite);
+        return 0;
+    }
 
-    /* set the new y coordinate */
+    /* clear out the y coordinate and the hidden flag, then set the new y,
+     * which is just above the screen once it wraps past 255 */
+    sprite->attribute0 &= 0xfc00;
     sprite->attribute0 |= (y & 0xff);
 
     /* clear out the x coordinate */
     sprite->attribute1 &= 0xfe00;
 
-    /* set the new x coordinate */
+    /* set the new x coordinate, 511 is one pixel left of the screen */
     sprite->attribute1 |= (x & 0x1ff);
+    return 1;
 }
 
 /* move a sprite in a direction */
 void sprite_move(struct Sprite* sprite, int dx, int dy) {
-    /* get the current y coordinate */
+    /* get the current y coordinate, the values below the screen are the
+     * ones wrapped round from above it */
     int y = sprite->attribute0 & 0xff;
+    if (y >= SCREEN_HEIGHT) {
+        y -= 256;
+    }
 
-    /* get the current x coordinate */
+    /* get the current x coordinate, which is 9 bits with a sign */
     int x = sprite->attribute1 & 0x1ff;
+    if (x & 0x100) {
+        x -= 512;
+    }
 
     /* move to the new location */
     sprite_position(sprite, x + dx, y + dy);
@@ -312,6 +430,17 @@ void sprite_set_horizontal_flip(struct Sprite* sprite, int horizontal_flip) {
     }
 }
 
+/* change whether a sprite is drawn see through, using the blend registers */
+void sprite_set_translucent(struct Sprite* sprite, int translucent) {
+    if (translucent) {
+        /* set the gfx mode to semi transparent */
+        sprite->attribute0 |= 0x0400;
+    } else {
+        /* back to normal */
+        sprite->attribute0 &= 0xf3ff;
+    }
+}
+
 /* change the tile offset of a sprite */
 void sprite_set_offset(struct Sprite* sprite, int offset) {
     /* clear the old offset */
@@ -324,17 +453,20 @@ void sprite_set_offset(struct Sprite* sprite, int offset) {
 /* setup the sprite image and palette */
 void setup_sprite_image() {
     /* load the palette from the image into palette memory*/
-    memcpy16_dma((unsigned short*) sprite_palette, (unsigned short*) realCopter_palette, PALETTE_SIZE);
-      
-    /* load the image into char block 0 */
-    memcpy16_dma((unsigned short*) sprite_image_memory, (unsigned short*) realCopter_data, (realCopter_width * realCopter_height) / 2);
+    pak_load(PAK_REALCOPTER_PALETTE);
+
+    /* load the image into the sprite tiles, and draw the sparks after it */
+    pak_load(PAK_REALCOPTER_DATA);
+    particles_setup(sprite_image_memory);
+    vram_claim(VRAM_OBJ_TILES + PARTICLE_TILE * 32, PARTICLE_FRAMES * 64, "sparks");
 }
 /* a struct for the koopa's logic and behavior */
 struct Wall {
     /* the actual sprite attribute info */
     struct Sprite* sprite;
 
-    /* the x and y postion */
+    /* the x postion is in the world and y is on the screen, origx is how far
+     * ahead of the camera it comes back once it has gone past */
     int x, y;
 	int origx, origy;
 
@@ -355,6 +487,9 @@ struct Copter {
     int frame;
     int move;
     int border;
+
+    /* how far it moved up or down last frame, up is negative */
+    int dy;
 };
 
 void copter_init(struct Copter* copter) {
@@ -363,18 +498,20 @@ void copter_init(struct Copter* copter) {
     copter->border = 18;
     copter->frame = 0;
     copter->move = 0;
+    copter->dy = 0;
     copter->sprite = sprite_init(copter->x, copter->y, SIZE_16_16, 0, 0, copter->frame, 0);
+    sprite_set_depth(copter->sprite, DEPTH_COPTER);
 }
 
 /* initialize the koopa */ //added x and y so function can be reused for multiple walls.
-void wall_init(struct Wall* wall, int x, int y) {
-     wall->x = x;//80
+void wall_init(struct Wall* wall, const struct Camera* camera, int x, int y) {
+     wall->x = camera_pixel_x(camera) + x;//80
      wall->y = y;//70
 	 wall->origx = x;
 	 wall->origy = y;
      wall->frame = 8;
      wall->explode = 0;
-     wall->sprite = sprite_init(wall->x, wall->y, SIZE_16_16, 0, 0, wall->frame, 0);
+     wall->sprite = sprite_init(x, wall->y, SIZE_16_16, 0, 0, wall->frame, 0);
      //wall->sprite = sprite_init(wall->x + 60, wall->y -30, SIZE_16_16, 0, 0, wall->frame, 0);
      //wall->sprite = sprite_init(wall->x + 120, wall->y +30, SIZE_16_16, 0, 0, wall->frame, 0);
 }
@@ -392,10 +529,16 @@ int wall_left(struct Wall* wal){
 		return 0;
 	}
 }*/
-int wallLeft(int curX, int origX);
 
-void wall_left(struct Wall *wall){
-	wall->x = wallLeft(wall->x, wall->origx);
+/* a wall slides all the way off the left of the screen before it goes
+ * back, and is hidden while it is off - walls stay put in the world, so
+ * they only move on the screen as the camera does */
+#define WALL_WIDTH 16
+
+void wall_left(struct Wall *wall, const struct Camera* camera){
+	if (camera_screen_x(camera, wall->x) <= -WALL_WIDTH) {
+		wall->x = camera_pixel_x(camera) + wall->origx;
+	}
 }
 
 
@@ -405,9 +548,11 @@ int copter_up(struct Copter* copter){
     //if(copter->y > (SCREEN_HEIGHT - 40 - copter->border)) {
 	if(copter->y <  0+20){
 		copter->move=0;
+        copter->dy = 0;
         return 1;
     } else{
         copter->y-=2;
+        copter->dy = -2;
         return 0;
     }
 }
@@ -416,9 +561,11 @@ int copter_fall(struct Copter* copter){
 	copter->move =1;
 	if(copter->y > (SCREEN_HEIGHT -20 - copter->border)){
 		copter->move=0;
+		copter->dy = 0;
 		return 1;
 	} else{
 		copter->y++;
+		copter->dy = 1;
 		return 0;
 	}
 	/*
@@ -439,6 +586,36 @@ void set_text(char* str, int row, int col){
     }
 }
 
+/* write a number into a string without dividing, by counting how many of
+ * each power of ten fit into it */
+void number_text(char* str, unsigned int number) {
+    static const unsigned int powers[] = {
+        1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1
+    };
+
+    int started = 0;
+    for (int i = 0; i < 10; i++) {
+        char digit = '0';
+        while (number >= powers[i]) {
+            number -= powers[i];
+            digit++;
+        }
+        if (digit != '0' || started || i == 9) {
+            *str++ = digit;
+            started = 1;
+        }
+    }
+    *str = 0;
+}
+
+/* blank out one row of text */
+void clear_text(int row) {
+    volatile unsigned short* background = screen_block(31);
+    for (int col = 0; col < 32; col++) {
+        background[row * 32 + col] = 0;
+    }
+}
+
 
 unsigned short tile_lookup(int x, int y, int xscroll, int yscroll, const unsigned short* tilemap, int tilemap_w, int tilemap_h) {
     x += xscroll;
@@ -469,123 +646,549 @@ void copter_update(struct Copter *cop){
 	sprite_position(cop->sprite, cop->x, cop->y);
 }
 
-void wall_update(struct Wall *wal){
-	sprite_position(wal->sprite, wal->x, wal->y);
+void wall_update(struct Wall *wal, const struct Camera* camera){
+    /* a wall that has blown up stays hidden */
+    if (wal->explode) {
+        return;
+    }
+	sprite_position(wal->sprite, camera_screen_x(camera, wal->x), wal->y);
 }
 
+/* the sparks only look nice, so they get their own numbers and never
+ * change how a run plays out */
+struct Random particle_random;
 
-void uppercase(char* s);
+/* how many sparks a crash throws out */
+#define CRASH_PARTICLES 128
+#define WALL_PARTICLES 48
 
-/* update the wall */
-int main( ) {
-   /* we set the mode to mode 0 with bg0 on */
-   *display_control = MODE0 | BG0_ENABLE | BG1_ENABLE | SPRITE_ENABLE | SPRITE_MAP_1D;
+/* blow the copter up, hiding its sprite behind the sparks */
+void copter_crash(struct Copter* copter) {
+    particles_burst(copter->x + 8, copter->y + 8, CRASH_PARTICLES, &particle_random);
+    sprite_hide(copter->sprite);
+}
 
-   /* setup the background 0 */
-   setup_background();
+/* blow up a wall the copter flew into */
+void wall_explode(struct Wall* wall, const struct Camera* camera) {
+    wall->explode = 1;
+    particles_burst(camera_screen_x(camera, wall->x) + 2, wall->y + 8, WALL_PARTICLES, &particle_random);
+    sprite_hide(wall->sprite);
+}
 
-   /* setup the sprite image data */
-   setup_sprite_image();
+/* check the copter's box against the rock of the cave, inset a little since
+ * the copter image does not fill its whole sprite */
+int copter_hit_cave(struct Copter* copter, struct Cave* cave, const struct Camera* camera) {
+    int left = copter->x + camera_pixel_x(camera) + 2;
+    int right = copter->x + camera_pixel_x(camera) + 13;
+    int top = copter->y + 3;
+    int bottom = copter->y + 12;
 
-   /* clear all the sprites on screen now */
-   sprite_clear();
+    return cave_solid(cave, left, top) || cave_solid(cave, right, top) ||
+        cave_solid(cave, left, bottom) || cave_solid(cave, right, bottom);
+}
+
+/* generate cave columns until the column just past the right edge of the
+ * screen exists, it only writes a new one each time we scroll 8 pixels */
+void cave_stream(struct Cave* cave, const struct Camera* camera) {
+    while (cave->column <= (int) (camera_pixel_x(camera) >> 3) + 31) {
+        cave_next_column(cave, screen_block(29), CAVE_TILE);
+    }
+}
+
+/* the groups of assets the scenes can ask for */
+#define ASSET_BACKGROUND 0
+#define ASSET_TEXT 1
+#define ASSET_CAVE 2
+#define ASSET_SPRITES 3
+
+/* the samples for the sound effects, in the arena after the replays */
+signed char* sound_buffer = NULL;
+
+/* the channel the rotor is looping on, or -1 */
+int rotor_channel = -1;
+#define ROTOR_VOLUME 40
+
+/* the rotor works harder climbing, so its pitch rises by this much for each
+ * pixel per frame the copter climbs, and falls as it drops */
+int rotor_pitch = MIXER_PITCH_ONE;
+#define ROTOR_PITCH_PER_SPEED 512
+
+/* the score at which the next milestone blip plays */
+unsigned int next_milestone = 100;
+
+/* the state of the current run, kept here so pausing leaves it alone - the
+ * walls are taken from a pool, which gets them all back each new run */
+#define WALL_COUNT 3
+struct Wall wall_memory[WALL_COUNT];
+struct Pool wall_pool;
+struct Wall* walls[WALL_COUNT];
+struct Copter copter;
+struct Cave cave;
+
+/* the camera moves along a pixel a frame from the start of the run, so how
+ * far it is along is the distance flown, which the cave and score count
+ * from - it wraps after 16 million pixels, over three days of flying */
+#define CAMERA_SPEED CAMERA_ONE
+struct Camera camera;
+
+/* the score is the number of tiles flown this run */
+unsigned int score = 0;
+
+/* the high scores and settings loaded from SRAM */
+struct SaveData save_data;
+
+/* the buttons of this run are recorded, and the best run so far is played
+ * back as a ghost - both replays are taken from the arena at start up, so
+ * they last through every scene, and swap buffers when a run becomes the
+ * new best */
+unsigned char* record_buffer = NULL;
+unsigned char* ghost_buffer = NULL;
+struct Replay recording;
+struct Replay ghost_replay;
+int has_ghost = 0;
+
+/* whether this run is racing the ghost, and the ghost's own copter */
+int racing_ghost = 0;
+struct Copter ghost;
+
+/* counts frames on the title screen to seed the course with */
+unsigned int title_frames = 0;
+struct Random seed_random;
+
+/* the scenes, defined below */
+struct Scene title_scene;
+struct Scene play_scene;
+struct Scene pause_scene;
+struct Scene gameover_scene;
+
+/* play a sound effect unless sound is turned off */
+int play_sound(const struct Sound* sound, int volume) {
+    if (!save_data.sound) {
+        return -1;
+    }
+    return mixer_play(sound, volume);
+}
+
+/* start the music from the top unless music is turned off */
+void play_music() {
+    if (save_data.music) {
+        psg_play(&theme_song);
+    }
+}
+
+/* empty out the cave map on background 2 */
+void clear_cave() {
+    volatile unsigned short* map = screen_block(29);
+    for (int i = 0; i < 32 * 32; i++) {
+        map[i] = 0;
+    }
+}
+
+/* set everything up for a fresh run, reusing the tiles already in VRAM */
+void new_run(unsigned int seed, int race) {
+    /* clear all the sprites on screen now */
+    sprite_clear();
+
+    /* blank out the last run's score */
+    set_text("          ", 0, 20);
+    set_text("0", 0, 20);
+
+    /* create the koopa */
+    /*struct Wall wallA;
+    struct Wall wallB;
+    struct Wall wally; //sorry I really wanted one to be named wall-ie */ //yes, I did just comment my comment. sue me. 
+    //sorry I'm a comment everything kinda guy
+    /* set initial scroll to 0, before the walls are put ahead of it */
+    camera_init(&camera, CAMERA_SPEED);
+
+    pool_clear(&wall_pool);
+    for (int i = 0; i < WALL_COUNT; i++) {
+        walls[i] = pool_alloc(&wall_pool);
+    }
+    wall_init(walls[0],&camera,240,40);
+    wall_init(walls[1],&camera,320,70);
+    wall_init(walls[2],&camera,360,100);
+    /* wall_init(&wallA,240,40);
+    wall_init(&wallB,320,70);
+    wall_init(&wally,360,100);*/
+
+    copter_init(&copter);
+
+    /* the ghost flies behind the player */
+    racing_ghost = race;
+    if (racing_ghost) {
+        copter_init(&ghost);
+        sprite_set_depth(ghost.sprite, DEPTH_GHOST);
+        sprite_set_translucent(ghost.sprite, 1);
+        replay_play_start(&ghost_replay);
+    }
+    replay_record_start(&recording, record_buffer, SAVE_REPLAY_CAPACITY, seed);
+
+    score = 0;
+    next_milestone = 100;
+
+    /* start the rotor going */
+    mixer_stop(rotor_channel);
+    rotor_channel = play_sound(&rotor_sound, ROTOR_VOLUME);
+    rotor_pitch = MIXER_PITCH_ONE;
+    play_music();
+
+    /* build the first screen of a new cave */
+    clear_cave();
+    cave_init(&cave, seed);
+    cave_stream(&cave, &camera);
+}
+
+/* start a run on a new course with start, or on the ghost's course with
+ * select, returns whether one was started */
+int menu_start_run() {
+    if (input_pressed(BUTTON_START)) {
+        new_run(random_next(&seed_random), 0);
+    } else if (has_ghost && save_data.ghost && input_pressed(BUTTON_SELECT)) {
+        new_run(ghost_replay.seed, 1);
+    } else {
+        return 0;
+    }
+    scene_change(&play_scene);
+    return 1;
+}
+
+/* show how to race the ghost, if there is one */
+void show_ghost_text(int row) {
+    if (has_ghost && save_data.ghost) {
+        set_text("SELECT RACE GHOST", row, 7);
+    }
+}
+
+/* the title screen waits for start, timing the player to seed the course */
+void title_enter() {
+    sprite_clear();
+    clear_cave();
+    camera_init(&camera, CAMERA_SPEED);
+    play_music();
+
+    char msg [32] = "Helicopter";
+    uppercase(msg);
+    set_text(msg, 0, 0);
+    set_text("PRESS START", 10, 10);
+
+    /* show the best score on record */
+    char line[32] = "HIGH SCORE ";
+    number_text(line + 11, save_data.scores[0]);
+    set_text(line, 12, 10);
+    show_ghost_text(14);
+}
+
+void title_update() {
+    title_frames++;
+    if (input_pressed(BUTTON_START | BUTTON_SELECT)) {
+        random_stir(&seed_random, title_frames);
+    }
+    menu_start_run();
+}
+
+void title_exit() {
+    clear_text(10);
+    clear_text(12);
+    clear_text(14);
+}
+
+/* the game itself */
+void play_update() {
+    particles_update();
+
+    /* update the wall */
+    /*wall_update(&wallA);
+    wall_update(&wallB);
+    wall_update(&wally);*/
+    int i;
+    for(i=0;i<WALL_COUNT;i++){
+        wall_update(walls[i], &camera);
+    }
+
+    for(i=0;i<WALL_COUNT;i++){
+        wall_left(walls[i], &camera);
+    }
+    /*wall_left(&wallA);
+    wall_left(&wallB);
+    wall_left(&wally);*/
+    //If all my commented code bothers you please delete it. 
+
+    /* the ghost flies on its recorded buttons until its run ended */
+    if (racing_ghost) {
+        copter_update(&ghost);
+        if (replay_done(&ghost_replay)) {
+            sprite_hide(ghost.sprite);
+        } else if (replay_play(&ghost_replay) & BUTTON_UP) {
+            copter_up(&ghost);
+        } else {
+            copter_fall(&ghost);
+        }
+    }
+
+    /* keep the buttons for replaying this run */
+    replay_record(&recording, input_keys());
+
+    copter_update(&copter);
+    if(input_held(BUTTON_UP)) {
+        copter_up(&copter);
+    }else{
+        copter_fall(&copter);
+    }
+    camera_update(&camera);
+    //check collision:
+    for(i=0;i<WALL_COUNT;i++){//walls are 8 pixels long right?    Walls are 3 pixels wide by 8 pixels height
+        //check x
+        //if(walls[i].x == (copter.x+copter.border)){
+        int wall_x = camera_screen_x(&camera, walls[i]->x);
+        if((wall_x<= (copter.x+copter.border)) && (wall_x>=copter.x)){
+            //check y
+            if((copter.y >= walls[i]->y) && (copter.y <= walls[i]->y+8)){
+                //collition!
+                wall_explode(walls[i], &camera);
+                copter_crash(&copter);
+                scene_change(&gameover_scene);
+                return;
+            }
+        }
+    }
+
+    /* ease the rotor pitch towards the copter's speed */
+    rotor_pitch += (MIXER_PITCH_ONE - copter.dy * ROTOR_PITCH_PER_SPEED - rotor_pitch) >> 3;
+    mixer_set_pitch(rotor_channel, rotor_pitch);
+
+    /* flying into the cave is a crash too */
+    if (copter_hit_cave(&copter, &cave, &camera)) {
+        copter_crash(&copter);
+        scene_change(&gameover_scene);
+        return;
+    }
+
+    /* bring in new cave columns as they scroll into view, which only
+     * happens when the camera moves onto a new column of tiles */
+    if (camera_crossed(&camera, 3)) {
+        cave_stream(&cave, &camera);
+    }
+
+    /* count the distance flown, updating the display when it changes */
+    if (score != camera_pixel_x(&camera) >> 3) {
+        char number[12];
+        score = camera_pixel_x(&camera) >> 3;
+        number_text(number, score);
+        set_text(number, 0, 20);
+
+        if (score >= next_milestone) {
+            play_sound(&pickup_sound, MIXER_MAX_VOLUME);
+            next_milestone += 100;
+        }
+    }
+
+    if (input_pressed(BUTTON_START)) {
+        scene_change(&pause_scene);
+    }
+}
+
+/* pausing freezes the run where it is */
+void pause_enter() {
+    set_text("PAUSED", 10, 12);
+    mixer_set_volume(rotor_channel, 0);
+}
+
+void pause_update() {
+    if (input_pressed(BUTTON_START)) {
+        scene_change(&play_scene);
+    }
+}
+
+void pause_exit() {
+    clear_text(10);
+    mixer_set_volume(rotor_channel, ROTOR_VOLUME);
+}
 
-   char msg [32] = "Helicopter";
-   uppercase(msg);
-   set_text(msg, 0, 0);
-
-   /* create the koopa */
-   /*struct Wall wallA;
-   struct Wall wallB;
-   struct Wall wally; //sorry I really wanted one to be named wall-ie */ //yes, I did just comment my comment. sue me. 
-   struct Wall walls[3];
-	//sorry I'm a comment everything kinda guy
-   wall_init(&walls[0],240,40);
-   wall_init(&walls[1],320,70);
-   wall_init(&walls[2],360,100);
-  /* wall_init(&wallA,240,40);
-   wall_init(&wallB,320,70);
-   wall_init(&wally,360,100);*/
-
-   struct Copter copter;
-   copter_init(&copter);
-
-   /* set initial scroll to 0 */
-   int xscroll = 0;
-   int yscroll = 0;
+/* the high score table is written out when game over starts, into lines
+ * taken from the arena so they go with the scene, and shown a line at a
+ * time down the bottom of the screen */
+#define TABLE_ROW 15
+#define TABLE_COL 10
+#define TABLE_DELAY 8
+char (*table_lines)[32] = NULL;
+int table_frames = 0;
+
+/* write out the lines of the high score table, a number and the score */
+void table_write() {
+    table_frames = 0;
+    table_lines = arena_alloc(SAVE_SCORES * sizeof(*table_lines));
+    if (table_lines == NULL) {
+        return;
+    }
+    for (int i = 0; i < SAVE_SCORES; i++) {
+        table_lines[i][0] = '1' + i;
+        table_lines[i][1] = ' ';
+        number_text(table_lines[i] + 2, save_data.scores[i]);
+    }
+}
+
+/* show the next line of the table every few frames */
+void table_update() {
+    if (table_lines == NULL || table_frames >= SAVE_SCORES * TABLE_DELAY) {
+        return;
+    }
+    table_frames++;
+    if (table_frames % TABLE_DELAY == 0) {
+        int line = table_frames / TABLE_DELAY - 1;
+        set_text(table_lines[line], TABLE_ROW + line, TABLE_COL);
+    }
+}
+
+/* game over leaves the crash on screen until start is pressed again */
+void gameover_enter() {
+    mixer_stop(rotor_channel);
+    rotor_channel = -1;
+    psg_play(NULL);
+    play_sound(&crash_sound, MIXER_MAX_VOLUME);
+
+    set_text("GAME OVER", 9, 11);
+    set_text("PRESS START", 10, 10);
+
+    /* a score which makes the table is saved over the next few frames */
+    if (save_insert_score(&save_data, score) >= 0) {
+        set_text("NEW HIGH SCORE", 12, 8);
+        save_begin(&save_data);
+    }
+
+    /* the best run becomes the ghost, and its buffer is not touched again
+     * until it is beaten, so it can be saved a little at a time */
+    recording.score = score;
+    if (!has_ghost || score > ghost_replay.score) {
+        ghost_replay = recording;
+        unsigned char* spare = ghost_buffer;
+        ghost_buffer = record_buffer;
+        record_buffer = spare;
+        has_ghost = 1;
+        save_begin_replay(&ghost_replay);
+    }
+    show_ghost_text(14);
+    table_write();
+}
+
+void gameover_update() {
+    /* the sparks from the crash carry on falling */
+    particles_update();
+    table_update();
+    menu_start_run();
+}
+
+void gameover_exit() {
+    clear_text(9);
+    clear_text(10);
+    clear_text(12);
+    clear_text(14);
+    for (int i = 0; i < SAVE_SCORES; i++) {
+        clear_text(TABLE_ROW + i);
+    }
+    table_lines = NULL;
+}
+
+struct Scene title_scene = {
+    title_enter, title_update, title_exit,
+    (1 << ASSET_BACKGROUND) | (1 << ASSET_TEXT)
+};
+struct Scene play_scene = {
+    NULL, play_update, NULL,
+    (1 << ASSET_BACKGROUND) | (1 << ASSET_TEXT) | (1 << ASSET_CAVE) | (1 << ASSET_SPRITES)
+};
+struct Scene pause_scene = {
+    pause_enter, pause_update, pause_exit,
+    (1 << ASSET_BACKGROUND) | (1 << ASSET_TEXT) | (1 << ASSET_CAVE) | (1 << ASSET_SPRITES)
+};
+struct Scene gameover_scene = {
+    gameover_enter, gameover_update, gameover_exit,
+    (1 << ASSET_BACKGROUND) | (1 << ASSET_TEXT) | (1 << ASSET_CAVE) | (1 << ASSET_SPRITES)
+};
+
+/* at the start of vblank the sound mixer swaps buffers first, since the
+ * sound DMA has to be restarted before it runs off the end of the one it is
+ * playing, then the sprites of the frame just made go up and the music
+ * moves on a frame */
+void interrupt_vblank( ) {
+    mixer_vblank();
+    mux_vblank();
+    psg_vblank();
+}
+
+int main( ) {
+   /* we set the mode to mode 0 with bg0 on */
+   *display_control = MODE0 | BG0_ENABLE | BG1_ENABLE | BG2_ENABLE | SPRITE_ENABLE | SPRITE_MAP_1D;
+   vram_use_objects(*display_control);
+
+   /* the scenes load these into VRAM the first time they need them */
+   pak_init();
+   scene_register_assets(ASSET_BACKGROUND, setup_background);
+   scene_register_assets(ASSET_TEXT, setup_text);
+   scene_register_assets(ASSET_CAVE, setup_cave);
+   scene_register_assets(ASSET_SPRITES, setup_sprite_image);
+
+   /* the buffers that last the whole game come out of EWRAM first, the
+    * scenes free anything they take after these - the profiler is started
+    * before so it sees them */
+   profile_init();
+   arena_init();
+   record_buffer = arena_alloc(SAVE_REPLAY_CAPACITY);
+   ghost_buffer = arena_alloc(SAVE_REPLAY_CAPACITY);
+   sound_buffer = arena_alloc(SOUNDS_BUFFER_SIZE);
+   pool_init(&wall_pool, wall_memory, sizeof(struct Wall), WALL_COUNT);
+
+   save_load(&save_data);
+   has_ghost = save_load_replay(&ghost_replay, ghost_buffer, SAVE_REPLAY_CAPACITY);
+   random_seed(&seed_random, 0);
+   random_seed(&particle_random, 0);
+
+   /* make the sound effects and start the mixer and music, which are kept
+    * in step by the vblank interrupt */
+   sounds_init(sound_buffer);
+   mixer_init();
+   psg_init();
+
+   /* the vblank handler is the least urgent, anything which has to happen
+    * at an exact time gets a higher priority and can interrupt it */
+   irq_init();
+   mux_init(1);   /* rewrites OAM at set lines, so it comes before vblank */
+   irq_set(IRQ_VBLANK, interrupt_vblank, 0);
+
+   /* the ghost is blended half and half with the backgrounds behind it */
+   *blend_control = (1 << 8) | (1 << 9) | (1 << 10) | (1 << 13);
+   *blend_alpha = 8 | (8 << 8);
+   sprite_clear();
+   scene_change(&title_scene);
 
    /* loop forever */
    while (1) {
-        /* update the wall */
-        /*wall_update(&wallA);
-		wall_update(&wallB);
-		wall_update(&wally);*/
-	   	int i;
-		for(i=0;i<3;i++){
-			wall_update(&walls[i]);
-		}
-		
-		for(i=0;i<3;i++){
-			wall_left(&walls[i]);
-		}
-		/*wall_left(&wallA);
-		wall_left(&wallB);
-		wall_left(&wally);*/
-		//If all my commented code bothers you please delete it. 
-
-        copter_update(&copter);
-		if(button_pressed(BUTTON_UP)) {
-        	copter_up(&copter);
-			xscroll++;
-        }else{
-            copter_fall(&copter);
-			xscroll++;
-        }
-		//check collision:
-		for(i=0;i<3;i++){//walls are 8 pixels long right?    Walls are 3 pixels wide by 8 pixels height
-			//check x
-			//if(walls[i].x == (copter.x+copter.border)){
-			if((walls[i].x<= (copter.x+copter.border)) && (walls[i].x>=copter.x)){
-				//check y
-				if((copter.y >= walls[i].y) && (copter.y <= walls[i].y+8)){
-						//collition!
-						return 0;
-				}
-			}
-		}
+        input_update();
+        scene_update();
+
+        /* the particles get whatever sprites are left over, and go at the
+         * back so they are the ones dropped if a band is full */
+        int particle_sprites = particles_draw((unsigned short*) &sprites[next_sprite_index],
+                                              NUM_SPRITES - next_sprite_index);
+        sprite_update_all(next_sprite_index + particle_sprites);
 
 		//copter moves up and down decent. starts choppy, but get smoother the longer the game runs
         /* wait for vblank before scrolling and moving sprites */
+        profile_end(PROFILE_FRAME);
+        profile_value(PROFILE_VRAM, vram_check.overlaps);
+        profile_frame();
         wait_vblank();
-        *bg0_x_scroll = xscroll;
-        sprite_update_all();
+        *bg0_x_scroll = camera_scroll_x(&camera);
+        *bg2_x_scroll = camera_scroll_x(&camera);
+        profile_begin(PROFILE_FRAME);
+
+        /* mix the sound for the next frame */
+        mixer_mix();
+
+        /* write a little of any pending save each frame */
+        save_step(SAVE_STEP_BYTES);
 
         /* delay some */
         delay(300);
     }   
 }
-
-/* the game boy advance uses "interrupts" to handle certain situations
-* for now we will ignore these */
-void interrupt_ignore( ) {
-    /* do nothing */
-}
-
-/* this table specifies which interrupts we handle which way
-* for now, we ignore all of them */
-typedef void (*intrp)( );
-const intrp IntrTable[13] = {
-    interrupt_ignore,   /* V Blank interrupt */
-    interrupt_ignore,   /* H Blank interrupt */
-    interrupt_ignore,   /* V Counter interrupt */
-    interrupt_ignore,   /* Timer 0 interrupt */
-    interrupt_ignore,   /* Timer 1 interrupt */
-    interrupt_ignore,   /* Timer 2 interrupt */
-    interrupt_ignore,   /* Timer 3 interrupt */
-    interrupt_ignore,   /* Serial communication interrupt */
-    interrupt_ignore,   /* DMA 0 interrupt */
-    interrupt_ignore,   /* DMA 1 interrupt */
-    interrupt_ignore,   /* DMA 2 interrupt */
-    interrupt_ignore,   /* DMA 3 interrupt */
-    interrupt_ignore,   /* Key interrupt */
-};
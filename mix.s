@@ -0,0 +1,116 @@
+@ mix.s
+@ inner loops of the sound mixer, these are ARM code in IWRAM since ROM is
+@ slow and only 16 bits wide, and they run for every sample of every frame
+    .section .iwram, "ax", %progbits
+    .arm
+    .align 2
+
+@ the channel being mixed, laid out as struct MixerChannel in mixer.c
+@ data, phase, step, end, volume, loop
+
+@ int mix_resample_nearest(int* total, int count, struct MixerChannel* channel)
+@ adds count samples of the channel times its volume into the total, moving
+@ through the sound by step each time (in 1/4096ths of a sample) and taking
+@ the nearest stored sample, returns 0 if a sound which does not loop ended
+    .global mix_resample_nearest
+mix_resample_nearest:
+    @ r0 is total, r1 is count, r2 is the channel
+    stmfd sp!, {r4-r11}
+    ldmia r2, {r3-r8}
+    cmp r1, #0
+    ble .nearestDone
+.nearestLoop:
+    @ go back to the start or stop once we pass the end
+    cmp r4, r6
+    blo .nearestMix
+    cmp r8, #0
+    beq .nearestEnd
+    sub r4, r4, r6
+.nearestMix:
+    mov r12, r4, lsr #12
+    ldrsb r12, [r3, r12]
+    ldr r10, [r0]
+    mla r10, r12, r7, r10
+    str r10, [r0], #4
+    add r4, r4, r5
+    subs r1, r1, #1
+    bgt .nearestLoop
+.nearestDone:
+    str r4, [r2, #4]
+    mov r0, #1
+    ldmfd sp!, {r4-r11}
+    bx lr
+.nearestEnd:
+    str r4, [r2, #4]
+    mov r0, #0
+    ldmfd sp!, {r4-r11}
+    bx lr
+
+@ int mix_resample_linear(int* total, int count, struct MixerChannel* channel)
+@ the same, but blends the two stored samples either side of the position -
+@ sounds keep a copy of their first sample after the end so the last one
+@ has something to blend with
+    .global mix_resample_linear
+mix_resample_linear:
+    @ r0 is total, r1 is count, r2 is the channel
+    stmfd sp!, {r4-r11}
+    ldmia r2, {r3-r8}
+    cmp r1, #0
+    ble .linearDone
+.linearLoop:
+    @ go back to the start or stop once we pass the end
+    cmp r4, r6
+    blo .linearMix
+    cmp r8, #0
+    beq .linearEnd
+    sub r4, r4, r6
+.linearMix:
+    @ this sample and how far it is to the next one
+    add r12, r3, r4, lsr #12
+    ldrsb r9, [r12]
+    ldrsb r10, [r12, #1]
+    sub r10, r10, r9
+    @ add on the fraction of the way between them
+    mov r11, r4, lsl #20
+    mov r11, r11, lsr #20
+    mul r12, r10, r11
+    add r9, r9, r12, asr #12
+    ldr r10, [r0]
+    mla r10, r9, r7, r10
+    str r10, [r0], #4
+    add r4, r4, r5
+    subs r1, r1, #1
+    bgt .linearLoop
+.linearDone:
+    str r4, [r2, #4]
+    mov r0, #1
+    ldmfd sp!, {r4-r11}
+    bx lr
+.linearEnd:
+    str r4, [r2, #4]
+    mov r0, #0
+    ldmfd sp!, {r4-r11}
+    bx lr
+
+@ void mix_clip(signed char* dest, int* total, int count)
+@ scales the total back down to 8 bits, clipping anything too loud, and
+@ zeroes the total ready for the next frame
+    .global mix_clip
+mix_clip:
+    @ r0 is dest, r1 is total, r2 is count
+    mov r3, #0
+    cmp r2, #0
+    ble .clipDone
+.clipLoop:
+    ldr r12, [r1]
+    str r3, [r1], #4
+    mov r12, r12, asr #6
+    cmp r12, #127
+    movgt r12, #127
+    cmn r12, #128
+    mvnlt r12, #127
+    strb r12, [r0], #1
+    subs r2, r2, #1
+    bgt .clipLoop
+.clipDone:
+    bx lr
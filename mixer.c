@@ -0,0 +1,201 @@
+/*
+ * mixer.c
+ * software sound mixer which mixes several 8 bit sounds into direct sound
+ * channel A, fed by DMA 1 each time timer 0 overflows
+ */
+
+#include <stddef.h>
+#include "mixer.h"
+#include "profile.h"
+
+/* a sound playing on a channel - the mixing loops in mix.s read the first
+ * six fields straight out of memory, so they must stay in this order */
+struct MixerChannel {
+    /* the samples, and the position in them in 1/4096ths of a sample */
+    const signed char* data;
+    unsigned int phase;
+
+    /* how far the position moves each output sample */
+    unsigned int step;
+
+    /* the length of the sound in the same units as the phase */
+    unsigned int end;
+
+    int volume;
+    int loop;
+
+    /* the sound playing, or NULL if the channel is free */
+    const struct Sound* sound;
+};
+
+/* the inner loops are ARM code in IWRAM (mix.s), which is too far from ROM
+ * for a plain branch so they have to be called through a register */
+int mix_resample_nearest(int* total, int count, struct MixerChannel* channel) __attribute__((long_call));
+int mix_resample_linear(int* total, int count, struct MixerChannel* channel) __attribute__((long_call));
+void mix_clip(signed char* dest, int* total, int count) __attribute__((long_call));
+
+/* pick the loop at build time */
+#if MIXER_INTERPOLATION == MIXER_NEAREST
+#define mix_resample mix_resample_nearest
+#else
+#define mix_resample mix_resample_linear
+#endif
+
+/* the sound control registers */
+static volatile unsigned short* sound_direct = (volatile unsigned short*) 0x4000082;
+static volatile unsigned short* sound_master = (volatile unsigned short*) 0x4000084;
+
+/* flags for direct sound channel A, full volume out of both speakers, driven
+ * by timer 0, and the bit which empties its FIFO */
+#define SOUND_A_FULL 0x0004
+#define SOUND_A_RIGHT 0x0100
+#define SOUND_A_LEFT 0x0200
+#define SOUND_A_TIMER0 0x0000
+#define SOUND_A_RESET 0x0800
+#define SOUND_MASTER_ENABLE 0x0080
+
+/* the FIFO which channel A plays from */
+static volatile unsigned int* fifo_a = (volatile unsigned int*) 0x40000a0;
+
+/* DMA 1, which refills the FIFO whenever it runs low */
+static volatile unsigned int* dma1_source = (volatile unsigned int*) 0x40000bc;
+static volatile unsigned int* dma1_destination = (volatile unsigned int*) 0x40000c0;
+static volatile unsigned int* dma1_count = (volatile unsigned int*) 0x40000c4;
+
+/* flags for DMA, the same as for DMA 3 in main.c plus the ones for sound -
+ * the destination stays on the FIFO and the transfer repeats each time the
+ * FIFO asks for more */
+#define DMA_ENABLE 0x80000000
+#define DMA_32 0x04000000
+#define DMA_REPEAT 0x02000000
+#define DMA_SPECIAL 0x30000000
+#define DMA_DEST_FIXED 0x00400000
+
+/* timer 0 overflows once per sample */
+static volatile unsigned short* timer0_data = (volatile unsigned short*) 0x4000100;
+static volatile unsigned short* timer0_control = (volatile unsigned short*) 0x4000102;
+#define TIMER_ENABLE 0x0080
+#define MIXER_TIMER_RELOAD (65536 - 924)
+
+static struct MixerChannel channels[MIXER_CHANNELS];
+
+/* two frames of samples, DMA plays straight through both of them and is
+ * sent back to the start every other vblank, while we mix the one that is
+ * not playing */
+static signed char buffer[MIXER_FRAME_SAMPLES * 2] __attribute__((aligned(4)));
+
+/* the sum of the channels for one frame, before it is clipped to 8 bits */
+static int total[MIXER_FRAME_SAMPLES];
+
+/* which half of the buffer DMA is playing, and whether the other needs mixing */
+static volatile int playing = 0;
+static volatile int mix_pending = 0;
+
+/* point DMA 1 at the start of the buffer */
+static void mixer_start_dma( ) {
+    *dma1_count = 0;
+    *dma1_source = (unsigned int) buffer;
+    *dma1_destination = (unsigned int) fifo_a;
+    *dma1_count = DMA_ENABLE | DMA_32 | DMA_REPEAT | DMA_SPECIAL | DMA_DEST_FIXED;
+}
+
+/* set up the sound hardware, timer 0 and DMA 1 */
+void mixer_init( ) {
+    for (int i = 0; i < MIXER_CHANNELS; i++) {
+        channels[i].sound = NULL;
+    }
+    for (int i = 0; i < MIXER_FRAME_SAMPLES * 2; i++) {
+        buffer[i] = 0;
+    }
+    for (int i = 0; i < MIXER_FRAME_SAMPLES; i++) {
+        total[i] = 0;
+    }
+
+    /* turn the sound on and send channel A to both speakers */
+    *sound_master = SOUND_MASTER_ENABLE;
+    *sound_direct = SOUND_A_FULL | SOUND_A_RIGHT | SOUND_A_LEFT | SOUND_A_TIMER0 | SOUND_A_RESET;
+
+    playing = 0;
+    mix_pending = 0;
+    mixer_start_dma();
+
+    /* and start the sample clock */
+    *timer0_control = 0;
+    *timer0_data = MIXER_TIMER_RELOAD;
+    *timer0_control = TIMER_ENABLE;
+}
+
+/* start a sound on a free channel, returns the channel or -1 if none free */
+int mixer_play(const struct Sound* sound, int volume) {
+    if (sound->length <= 0) {
+        return -1;
+    }
+    for (int i = 0; i < MIXER_CHANNELS; i++) {
+        if (channels[i].sound == NULL) {
+            channels[i].data = sound->data;
+            channels[i].phase = 0;
+            channels[i].step = MIXER_PITCH_ONE;
+            channels[i].end = sound->length * MIXER_PITCH_ONE;
+            channels[i].volume = volume;
+            channels[i].loop = sound->loop;
+            channels[i].sound = sound;
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* stop the sound on a channel */
+void mixer_stop(int channel) {
+    if (channel >= 0) {
+        channels[channel].sound = NULL;
+    }
+}
+
+/* change the volume of a channel */
+void mixer_set_volume(int channel, int volume) {
+    if (channel >= 0) {
+        channels[channel].volume = volume;
+    }
+}
+
+/* change the pitch of a channel, MIXER_PITCH_ONE is normal */
+void mixer_set_pitch(int channel, int pitch) {
+    if (channel >= 0) {
+        channels[channel].step = pitch;
+    }
+}
+
+/* swap the buffers, this must be called from the vblank interrupt */
+void mixer_vblank( ) {
+    if (playing) {
+        /* DMA has played the second half, send it back to the first */
+        mixer_start_dma();
+        playing = 0;
+    } else {
+        /* DMA carries on into the second half by itself */
+        playing = 1;
+    }
+    mix_pending = 1;
+}
+
+/* mix the next frame of sound if it needs it, once a frame after vblank */
+void mixer_mix( ) {
+    if (!mix_pending) {
+        return;
+    }
+    mix_pending = 0;
+    profile_begin(PROFILE_MIXER);
+
+    for (int i = 0; i < MIXER_CHANNELS; i++) {
+        /* a whole frame per call, the loop handles looping itself */
+        if (channels[i].sound && !mix_resample(total, MIXER_FRAME_SAMPLES, &channels[i])) {
+            channels[i].sound = NULL;
+        }
+    }
+
+    /* clip into the half DMA is not playing, which also zeroes the total */
+    mix_clip(buffer + (playing ^ 1) * MIXER_FRAME_SAMPLES, total, MIXER_FRAME_SAMPLES);
+
+    profile_end(PROFILE_MIXER);
+}
@@ -0,0 +1,65 @@
+/*
+ * mixer.h
+ * software sound mixer which mixes several 8 bit sounds into direct sound
+ * channel A, fed by DMA 1 each time timer 0 overflows
+ */
+
+#ifndef MIXER_H
+#define MIXER_H
+
+/* the number of sounds that can play at once */
+#define MIXER_CHANNELS 4
+
+/* the playback rate, 304 samples per frame at 59.73 frames per second -
+ * the timer counts 924 cycles between samples */
+#define MIXER_RATE 18157
+#define MIXER_FRAME_SAMPLES 304
+
+/* full volume for a channel, the sum of all channels is clipped */
+#define MIXER_MAX_VOLUME 64
+
+/* pitch is how far through the sound each output sample moves, in 1/4096ths
+ * of a stored sample, so this plays a sound as it was recorded */
+#define MIXER_PITCH_ONE 4096
+
+/* how the mixer works out the samples between the stored ones when a sound
+ * is played at another pitch - nearest is cheaper, linear sounds smoother */
+#define MIXER_NEAREST 0
+#define MIXER_LINEAR 1
+#ifndef MIXER_INTERPOLATION
+#define MIXER_INTERPOLATION MIXER_LINEAR
+#endif
+
+/* a sound is just signed 8 bit samples at the mixer rate, with one extra
+ * sample after the end for blending with - a copy of the first sample if it
+ * loops, or zero if not */
+struct Sound {
+    const signed char* data;
+    int length;
+
+    /* whether it goes back to the start when it finishes */
+    int loop;
+};
+
+/* set up the sound hardware, timer 0 and DMA 1 */
+void mixer_init( );
+
+/* start a sound on a free channel, returns the channel or -1 if none free */
+int mixer_play(const struct Sound* sound, int volume);
+
+/* stop the sound on a channel */
+void mixer_stop(int channel);
+
+/* change the volume of a channel */
+void mixer_set_volume(int channel, int volume);
+
+/* change the pitch of a channel, MIXER_PITCH_ONE is normal */
+void mixer_set_pitch(int channel, int pitch);
+
+/* swap the buffers, this must be called from the vblank interrupt */
+void mixer_vblank( );
+
+/* mix the next frame of sound if it needs it, once a frame after vblank */
+void mixer_mix( );
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ * mux.c
+ * sprite multiplexer, which shows more sprites than the 128 OAM has room
+ * for by sorting them into bands down the screen and rewriting half of OAM
+ * from the vcount interrupt each time the one before last is done with it
+ */
+
+#include <stddef.h>
+#include "mux.h"
+#include "irq.h"
+
+/* OAM, written a word and a halfword at a time so the affine parameters in
+ * the fourth halfword of each entry are left alone */
+static volatile unsigned short* oam = (volatile unsigned short*) 0x7000000;
+
+/* the display status register, the vcount line goes in the top byte */
+static volatile unsigned short* display_status = (volatile unsigned short*) 0x4000004;
+
+/* the flag which turns a sprite off, and the line past the bottom */
+#define MUX_HIDDEN 0x0200
+#define MUX_SCREEN_HEIGHT 160
+
+/* one frame of sprites sorted into bands, the first three halfwords of each
+ * one in band order, and where each band starts */
+struct MuxFrame {
+    unsigned short entries[MUX_MAX][3];
+    unsigned short start[MUX_BANDS + 1];
+};
+
+/* one frame being shown and one being sorted, and whether the sorted one is
+ * finished and waiting for vblank */
+static struct MuxFrame frames[2];
+static struct MuxFrame* volatile shown = &frames[0];
+static struct MuxFrame* volatile sorted = &frames[1];
+static volatile int ready = 0;
+
+/* the next band for the interrupt to write, and how many entries of each
+ * half of OAM are in use */
+static int next_band = 0;
+static int half_used[2] = {MUX_HALF, MUX_HALF};
+
+/* the height of a sprite in pixels, by its shape bits then its size bits,
+ * 0 for the shape that does not exist */
+static const unsigned char mux_heights[4][4] = {
+    {8, 16, 32, 64}, {8, 8, 16, 32}, {16, 32, 32, 64}, {0, 0, 0, 0}
+};
+
+/* the band a sprite starts in, or -1 if it is not on the screen or is too
+ * tall to be shown - y wraps at 256, so the top few values are just above
+ * the screen, and a double size affine sprite is twice its height */
+static int mux_band(const unsigned short* sprite) {
+    unsigned short attribute0 = sprite[0];
+    if ((attribute0 & 0x0300) == MUX_HIDDEN) {
+        return -1;
+    }
+    int height = mux_heights[attribute0 >> 14][sprite[1] >> 14];
+    if ((attribute0 & 0x0300) == 0x0300) {
+        height *= 2;
+    }
+    if (height == 0 || height > MUX_MAX_HEIGHT) {
+        return -1;
+    }
+    int y = attribute0 & 0xff;
+    if (y >= 256 - MUX_MAX_HEIGHT) {
+        return 0;
+    }
+    if (y >= MUX_SCREEN_HEIGHT) {
+        return -1;
+    }
+    return y / MUX_BAND_HEIGHT;
+}
+
+/* copy a band into its half of OAM, hiding entries its last band used */
+static void mux_write_band(int band) {
+    struct MuxFrame* frame = shown;
+    int half = band & 1;
+    volatile unsigned short* entry = oam + half * MUX_HALF * 4;
+    int first = frame->start[band], count = frame->start[band + 1] - first;
+    for (int i = 0; i < count; i++, entry += 4) {
+        const unsigned short* source = frame->entries[first + i];
+        entry[0] = source[0];
+        entry[1] = source[1];
+        entry[2] = source[2];
+    }
+    for (int i = count; i < half_used[half]; i++, entry += 4) {
+        entry[0] = MUX_HIDDEN;
+    }
+    half_used[half] = count;
+}
+
+/* point the vcount interrupt at the line a band's half should be written */
+static void mux_set_line(int band) {
+    int line = band * MUX_BAND_HEIGHT - MUX_LEAD;
+    *display_status = (*display_status & 0x00ff) | (line << 8);
+}
+
+/* the vcount interrupt writes the next band and moves on to the one after */
+static void mux_vcount( ) {
+    if (next_band >= MUX_BANDS) {
+        return;
+    }
+    mux_write_band(next_band++);
+    if (next_band < MUX_BANDS) {
+        mux_set_line(next_band);
+    }
+}
+
+/* hide everything and take the vcount interrupt at a priority */
+void mux_init(int priority) {
+    for (int i = 0; i < MUX_HALF * 2; i++) {
+        oam[i * 4] = MUX_HIDDEN;
+    }
+    for (int i = 0; i <= MUX_BANDS; i++) {
+        frames[0].start[i] = 0;
+        frames[1].start[i] = 0;
+    }
+    half_used[0] = 0;
+    half_used[1] = 0;
+    next_band = MUX_BANDS;
+    ready = 0;
+    irq_set(IRQ_VCOUNT, mux_vcount, priority);
+}
+
+/* sort a frame's sprites into bands with a counting sort, which keeps them
+ * in the order they were given inside each band */
+int mux_frame(const unsigned short* sprites, int count) {
+    /* vblank leaves the frame alone until it is finished */
+    ready = 0;
+    struct MuxFrame* frame = sorted;
+    unsigned short sizes[MUX_BANDS] = {0};
+    if (count > MUX_MAX) {
+        count = MUX_MAX;
+    }
+    for (int i = 0; i < count; i++) {
+        int band = mux_band(sprites + i * 4);
+        if (band >= 0 && sizes[band] < MUX_HALF) {
+            sizes[band]++;
+        }
+    }
+
+    unsigned short next[MUX_BANDS];
+    frame->start[0] = 0;
+    for (int band = 0; band < MUX_BANDS; band++) {
+        next[band] = frame->start[band];
+        frame->start[band + 1] = frame->start[band] + sizes[band];
+    }
+    for (int i = 0; i < count; i++) {
+        int band = mux_band(sprites + i * 4);
+        if (band >= 0 && next[band] < frame->start[band + 1]) {
+            unsigned short* entry = frame->entries[next[band]++];
+            entry[0] = sprites[i * 4];
+            entry[1] = sprites[i * 4 + 1];
+            entry[2] = sprites[i * 4 + 2];
+        }
+    }
+    ready = 1;
+    return frame->start[MUX_BANDS];
+}
+
+/* at the start of vblank, show the last frame handed over - if the game is
+ * still sorting one, the old frame is shown again */
+void mux_vblank( ) {
+    if (ready) {
+        struct MuxFrame* frame = shown;
+        shown = sorted;
+        sorted = frame;
+        ready = 0;
+    }
+    mux_write_band(0);
+    mux_write_band(1);
+    next_band = 2;
+    mux_set_line(next_band);
+}
@@ -0,0 +1,43 @@
+/*
+ * mux.h
+ * sprite multiplexer, which shows more sprites than the 128 OAM has room
+ * for by sorting them into bands down the screen and rewriting half of OAM
+ * from the vcount interrupt each time the one before last is done with it
+ */
+
+#ifndef MUX_H
+#define MUX_H
+
+/* the most sprites the game can hand over in a frame */
+#define MUX_MAX 256
+
+/* the screen is cut into bands, and each band's sprites go in one half of
+ * OAM - even bands in the first half and odd ones in the second - sprites
+ * keep the order they were handed over in only within their band: a sprite
+ * from an even band is always drawn over one from an odd band where they
+ * overlap, since the first half of OAM draws in front of the second */
+#define MUX_BAND_HEIGHT 32
+#define MUX_BANDS 5
+#define MUX_HALF 64
+
+/* a sprite must have left the screen before its half of OAM is written two
+ * bands later, so none can be taller than this - the copters and walls are
+ * 16 and particles 8 - and each half is written this many lines before its
+ * band starts - taller sprites are never shown */
+#define MUX_MAX_HEIGHT 16
+#define MUX_LEAD (MUX_BAND_HEIGHT - MUX_MAX_HEIGHT - 2)
+
+/* hide everything and take the vcount interrupt at a priority */
+void mux_init(int priority);
+
+/* sort a frame's sprites, OAM entries of four halfwords each, into bands
+ * for the next vblank - any off the screen or taller than MUX_MAX_HEIGHT
+ * are left out, as are any past the first 64 starting in a band, so put the
+ * ones that matter first - returns the number that will be shown */
+int mux_frame(const unsigned short* sprites, int count);
+
+/* at the start of vblank, show the last frame handed over - writes the
+ * first two bands and sets up the interrupt for the rest */
+void mux_vblank( );
+
+#endif
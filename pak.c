@@ -0,0 +1,173 @@
+/*
+ * pak.c
+ * the game's images packed into one archive in ROM by tools/gbaassets, with
+ * a directory sorted by ID - each one is copied or unpacked into the part
+ * of VRAM it belongs in only when something asks for it, and what is in
+ * VRAM is tracked so nothing is loaded twice
+ */
+
+#include <stddef.h>
+#include "pak.h"
+#include "vram.h"
+
+/* the archive, put into ROM by pak_bin.s */
+extern const unsigned int pak[];
+
+/* the directory after the magic and count */
+#define PAK_DIRECTORY ((const struct PakEntry*) (pak + 2))
+
+/* where each slot starts */
+#define PAK_VRAM 0x6000000
+#define PAK_BLOCK_SIZE 0x4000
+#define PAK_PALETTE 0x5000000
+
+/* the ID loaded into each slot plus one, 0 if none, and how many slots it
+ * runs over - anything over 16K spills into the next char block */
+static unsigned short resident[PAK_SLOTS];
+static unsigned char span[PAK_SLOTS];
+
+/* the number of entries, 0 if the archive is not there */
+static int count = 0;
+
+/* what each entry is called, for the VRAM claims */
+static const char* const names[PAK_COUNT] = {PAK_NAMES};
+
+/* DMA channel 3 copies anything not compressed */
+#define DMA_ENABLE 0x80000000
+#define DMA_16 0x00000000
+static volatile unsigned int* dma_source = (volatile unsigned int*) 0x40000D4;
+static volatile unsigned int* dma_destination = (volatile unsigned int*) 0x40000D8;
+static volatile unsigned int* dma_count = (volatile unsigned int*) 0x40000DC;
+
+/* copy halfwords with DMA, in pieces no bigger than its count can hold */
+static void pak_copy(volatile unsigned short* dest, const unsigned short* source, int amount) {
+    while (amount > 0) {
+        int piece = amount > 0x8000 ? 0x8000 : amount;
+        *dma_source = (unsigned int) source;
+        *dma_destination = (unsigned int) dest;
+        *dma_count = piece | DMA_16 | DMA_ENABLE;
+        source += piece;
+        dest += piece;
+        amount -= piece;
+    }
+}
+
+/* unpack LZ77 straight into VRAM with the BIOS, which writes a halfword at
+ * a time - the call number goes in the top byte in ARM code */
+static void pak_unpack(volatile void* dest, const void* source) {
+    register const void* r0 __asm__("r0") = source;
+    register volatile void* r1 __asm__("r1") = dest;
+#ifdef __thumb__
+    __asm__ __volatile__("swi 0x12" : "+r"(r0), "+r"(r1) : : "r2", "r3", "memory");
+#else
+    __asm__ __volatile__("swi 0x120000" : "+r"(r0), "+r"(r1) : : "r2", "r3", "memory");
+#endif
+}
+
+/* find an entry in the directory, which is sorted by ID */
+static const struct PakEntry* pak_find(int id) {
+    int low = 0, high = count - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        const struct PakEntry* entry = &PAK_DIRECTORY[middle];
+        if (entry->id == id) {
+            return entry;
+        } else if (entry->id < id) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return NULL;
+}
+
+/* check the archive is there and forget everything loaded */
+void pak_init( ) {
+    count = (pak[0] == PAK_MAGIC) ? pak[1] : 0;
+    for (int slot = 0; slot < PAK_SLOTS; slot++) {
+        resident[slot] = 0;
+        span[slot] = 0;
+    }
+}
+
+/* where an entry is in ROM and its size there, NULL if it is not in the pak */
+const void* pak_data(int id, int* size) {
+    const struct PakEntry* entry = pak_find(id);
+    if (entry == NULL) {
+        return NULL;
+    }
+    if (size) {
+        *size = entry->size;
+    }
+    return (const unsigned char*) pak + entry->offset;
+}
+
+/* load an entry into its slot unless it is already there, returns 1 if it
+ * was loaded, 0 if there was nothing to do and -1 if it is not in the pak */
+int pak_load(int id) {
+    const struct PakEntry* entry = pak_find(id);
+    if (entry == NULL) {
+        return -1;
+    }
+    int slot = entry->slot;
+    if (slot >= PAK_SLOTS || resident[slot] == id + 1) {
+        return 0;
+    }
+
+    const unsigned char* source = (const unsigned char*) pak + entry->offset;
+    volatile unsigned short* dest;
+    if (slot >= PAK_SLOT_BG_PALETTE) {
+        dest = (volatile unsigned short*) (PAK_PALETTE + (slot - PAK_SLOT_BG_PALETTE) * 0x200);
+    } else {
+        dest = (volatile unsigned short*) (PAK_VRAM + slot * PAK_BLOCK_SIZE);
+    }
+
+    /* LZ77 has the unpacked size after its first byte */
+    unsigned int length = entry->size;
+    if (entry->compression == PAK_LZ77) {
+        length = *(const unsigned int*) source >> 8;
+        pak_unpack(dest, source);
+    } else {
+        pak_copy(dest, (const unsigned short*) source, length / 2);
+    }
+
+    /* it takes over from whatever was in its slot before, and claims the
+     * VRAM it used, which catches it running over anything else */
+    if (slot < PAK_SLOT_BG_PALETTE) {
+        if (resident[slot]) {
+            vram_release(names[resident[slot] - 1]);
+        }
+        vram_claim(slot * PAK_BLOCK_SIZE, length, names[id]);
+    }
+
+    /* anything it wrote over is gone */
+    int blocks = 1;
+    if (slot < PAK_SLOT_BG_PALETTE) {
+        blocks = (length + PAK_BLOCK_SIZE - 1) / PAK_BLOCK_SIZE;
+    }
+    for (int other = 0; other < PAK_SLOTS; other++) {
+        if (resident[other] && other < slot + blocks && slot < other + span[other]) {
+            resident[other] = 0;
+        }
+    }
+    resident[slot] = id + 1;
+    span[slot] = blocks;
+    return 1;
+}
+
+/* returns 1 if an entry is in its slot right now */
+int pak_resident(int id) {
+    const struct PakEntry* entry = pak_find(id);
+    return entry && entry->slot < PAK_SLOTS && resident[entry->slot] == id + 1;
+}
+
+/* forget what is in some slots, one bit each, after writing over them
+ * some other way - along with anything running over into them */
+void pak_invalidate(unsigned int slots) {
+    for (int slot = 0; slot < PAK_SLOTS; slot++) {
+        unsigned int covered = ((1 << span[slot]) - 1) << slot;
+        if (slots & covered) {
+            resident[slot] = 0;
+        }
+    }
+}
@@ -0,0 +1,60 @@
+/*
+ * pak.h
+ * the game's images packed into one archive in ROM by tools/gbaassets, with
+ * a directory sorted by ID - each one is copied or unpacked into the part
+ * of VRAM it belongs in only when something asks for it, and what is in
+ * VRAM is tracked so nothing is loaded twice
+ */
+
+#ifndef PAK_H
+#define PAK_H
+
+/* the IDs of everything in the archive, made by tools/gbaassets */
+#include "pak_ids.h"
+
+/* "HPAK" at the start of the archive */
+#define PAK_MAGIC 0x4b415048
+
+/* where an entry is loaded to - slots 0 to 5 are the 16K char blocks, so
+ * 4 and 5 are the sprite tiles, then the two palettes */
+#define PAK_SLOT_BG_PALETTE 6
+#define PAK_SLOT_OBJ_PALETTE 7
+#define PAK_SLOTS 8
+
+/* an entry which stays in ROM, like a screen map the game copies itself */
+#define PAK_SLOT_ROM 0xff
+
+/* how an entry is stored */
+#define PAK_RAW 0
+#define PAK_LZ77 1
+
+/* the archive starts with the magic and the number of entries, then the
+ * directory, sorted by ID, then the entries themselves, each word aligned */
+struct PakEntry {
+    /* from the start of the archive, and the size stored there */
+    unsigned int offset;
+    unsigned int size;
+
+    unsigned short id;
+    unsigned char slot;
+    unsigned char compression;
+};
+
+/* check the archive is there and forget everything loaded */
+void pak_init( );
+
+/* where an entry is in ROM and its size there, NULL if it is not in the pak */
+const void* pak_data(int id, int* size);
+
+/* load an entry into its slot unless it is already there, returns 1 if it
+ * was loaded, 0 if there was nothing to do and -1 if it is not in the pak */
+int pak_load(int id);
+
+/* returns 1 if an entry is in its slot right now */
+int pak_resident(int id);
+
+/* forget what is in some slots, one bit each, after writing over them
+ * some other way */
+void pak_invalidate(unsigned int slots);
+
+#endif
@@ -0,0 +1,8 @@
+@ pak_bin.s
+@ made by tools/gbaassets, every image in one archive, see pak.h
+    .section .rodata
+
+    .align 2
+    .global pak
+pak:
+    .incbin "assets/pak.bin"
@@ -0,0 +1,27 @@
+/* pak_ids.h
+ * made by tools/gbaassets, the IDs of the entries in assets/pak.bin, which
+ * goes into ROM through pak_bin.s */
+
+#ifndef PAK_IDS_H
+#define PAK_IDS_H
+
+#define PAK_REALHELI_DATA              0 /* 3264 bytes, into char block 0 */
+#define PAK_BACKGROUNDS_PALETTE        1 /* 512 bytes, into the background palette */
+#define PAK_REALHELI_MAP               2 /* 2048 bytes, left in ROM */
+#define PAK_REALCOPTER_DATA            3 /* 512 bytes, into the sprite tiles */
+#define PAK_REALCOPTER_PALETTE         4 /* 512 bytes, into the sprite palette */
+#define PAK_BACKGROUND_DATA            5 /* 6144 bytes, into char block 3 */
+
+/* the number of entries */
+#define PAK_COUNT 6
+
+/* their names in ID order, for debug builds to show */
+#define PAK_NAMES \
+    "realHeli data", \
+    "backgrounds palette", \
+    "realHeli map", \
+    "realCopter data", \
+    "realCopter palette", \
+    "background data"
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ * particles.c
+ * sparks thrown out by crashes, kept as arrays of each field in IWRAM and
+ * moved all together once a frame, then drawn as 8x8 sprites into whatever
+ * sprite entries the game's own sprites have left
+ */
+
+#include "particles.h"
+#include "profile.h"
+
+/* the particles alive, oldest first - each field has its own array so the
+ * update runs straight down each one */
+static int x[PARTICLE_MAX];
+static int y[PARTICLE_MAX];
+static short dx[PARTICLE_MAX];
+static short dy[PARTICLE_MAX];
+static unsigned char life[PARTICLE_MAX];
+static unsigned char frame[PARTICLE_MAX];
+static int count = 0;
+
+/* how many OAM entries were drawn last frame, only those need hiding */
+static int drawn = 0;
+
+/* the screen is 240x160 */
+#define PARTICLE_SCREEN_WIDTH 240
+#define PARTICLE_SCREEN_HEIGHT 160
+
+/* OAM flags, a 256 color sprite and the flag which turns one off */
+#define PARTICLE_256_COLORS 0x2000
+#define PARTICLE_HIDDEN 0x0200
+
+/* the color in the middle of each look and around it, from the copter's
+ * palette - white and pink, fading to red and dark red */
+static const unsigned char core_colors[PARTICLE_FRAMES] = {3, 5, 4, 2};
+static const unsigned char edge_colors[PARTICLE_FRAMES] = {5, 4, 2, 1};
+
+/* the radius of each look in pixels around the middle of the tile */
+static const unsigned char sizes[PARTICLE_FRAMES] = {3, 2, 2, 1};
+
+/* draw the four looks into the sprite tiles, each a square which shrinks
+ * and darkens - 256 color tiles take a byte a pixel, written in pairs */
+void particles_setup(volatile unsigned short* sprite_tiles) {
+    for (int f = 0; f < PARTICLE_FRAMES; f++) {
+        volatile unsigned short* tile = sprite_tiles + (PARTICLE_TILE + f * 2) * 16;
+        for (int row = 0; row < 8; row++) {
+            for (int col = 0; col < 8; col += 2) {
+                unsigned short pair = 0;
+                for (int half = 0; half < 2; half++) {
+                    int distance_x = (col + half) - 4, distance_y = row - 4;
+                    distance_x = distance_x < 0 ? -distance_x - 1 : distance_x;
+                    distance_y = distance_y < 0 ? -distance_y - 1 : distance_y;
+                    int distance = distance_x > distance_y ? distance_x : distance_y;
+                    unsigned char color = 0;
+                    if (distance < sizes[f] - 1) {
+                        color = core_colors[f];
+                    } else if (distance < sizes[f]) {
+                        color = edge_colors[f];
+                    }
+                    pair |= color << (half * 8);
+                }
+                tile[row * 4 + col / 2] = pair;
+            }
+        }
+    }
+}
+
+/* get rid of every particle */
+void particles_clear( ) {
+    count = 0;
+}
+
+/* throw out count particles from a point on the screen, in all directions
+ * and mostly upwards - if there is not room, the oldest go first */
+void particles_burst(int px, int py, int amount, struct Random* random) {
+    if (amount > PARTICLE_MAX) {
+        amount = PARTICLE_MAX;
+    }
+    int drop = count + amount - PARTICLE_MAX;
+    if (drop > 0) {
+        for (int i = drop; i < count; i++) {
+            x[i - drop] = x[i];
+            y[i - drop] = y[i];
+            dx[i - drop] = dx[i];
+            dy[i - drop] = dy[i];
+            life[i - drop] = life[i];
+            frame[i - drop] = frame[i];
+        }
+        count -= drop;
+    }
+
+    for (int i = 0; i < amount; i++) {
+        x[count] = (px - 4) * PARTICLE_ONE;
+        y[count] = (py - 4) * PARTICLE_ONE;
+        dx[count] = random_between(random, -2 * PARTICLE_ONE, 2 * PARTICLE_ONE);
+        dy[count] = random_between(random, -3 * PARTICLE_ONE, PARTICLE_ONE);
+        life[count] = random_between(random, PARTICLE_LIFE * 3 / 4, PARTICLE_LIFE - 1);
+        frame[count] = 0;
+        count++;
+    }
+}
+
+/* move every particle along a frame, and burn them down - the dead ones and
+ * any gone off the screen are closed up over, keeping the oldest first */
+void particles_update( ) {
+    profile_begin(PROFILE_PARTICLES);
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        int nx = x[i] + dx[i];
+        int ny = y[i] + dy[i];
+        int left = life[i] - 1;
+        if (left <= 0 || nx < -8 * PARTICLE_ONE || nx >= PARTICLE_SCREEN_WIDTH * PARTICLE_ONE ||
+                ny >= PARTICLE_SCREEN_HEIGHT * PARTICLE_ONE) {
+            continue;
+        }
+        x[kept] = nx;
+        y[kept] = ny;
+        dx[kept] = dx[i];
+        dy[kept] = dy[i] + PARTICLE_GRAVITY;
+        life[kept] = left;
+        frame[kept] = (PARTICLE_FRAMES - 1) - (left * PARTICLE_FRAMES) / PARTICLE_LIFE;
+        kept++;
+    }
+    count = kept;
+    profile_end(PROFILE_PARTICLES);
+}
+
+/* write the particles into OAM entries, newest first so the oldest are the
+ * ones left out when there are not enough entries - returns the number
+ * drawn */
+int particles_draw(volatile unsigned short* oam, int slots) {
+    int used = 0;
+    for (int i = count - 1; i >= 0 && used < slots; i--) {
+        int sx = x[i] >> 8, sy = y[i] >> 8;
+
+        /* one wholly above the screen takes no entry */
+        if (sy <= -8) {
+            continue;
+        }
+
+        /* x wraps at 512 and y at 256, so a little off the top or left
+         * edge shows the part still on the screen */
+        volatile unsigned short* entry = oam + used * 4;
+        entry[0] = (sy & 0xff) | PARTICLE_256_COLORS;
+        entry[1] = sx & 0x1ff;
+        entry[2] = PARTICLE_TILE + frame[i] * 2;
+        used++;
+    }
+
+    /* hide the entries which had particles last frame but not now */
+    for (int i = used; i < drawn && i < slots; i++) {
+        oam[i * 4] = PARTICLE_HIDDEN;
+    }
+    drawn = used;
+    return used;
+}
+
+/* the number alive */
+int particles_count( ) {
+    return count;
+}
@@ -0,0 +1,53 @@
+/*
+ * particles.h
+ * sparks thrown out by crashes, kept as arrays of each field in IWRAM and
+ * moved all together once a frame, then drawn as 8x8 sprites into whatever
+ * sprite entries the game's own sprites have left
+ */
+
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "random.h"
+
+/* the most particles alive at once, a burst past this drops the oldest -
+ * more than OAM holds, which the multiplexer makes room for */
+#define PARTICLE_MAX 192
+
+/* positions and speeds are in 1/256ths of a pixel */
+#define PARTICLE_ONE 256
+
+/* pulled down this much each frame */
+#define PARTICLE_GRAVITY 12
+
+/* how many frames each one lives, and its four looks as it burns out */
+#define PARTICLE_LIFE 32
+#define PARTICLE_FRAMES 4
+
+/* where the looks go in the sprite tiles - in 32 byte units like OAM uses,
+ * so just past the copter's 512 bytes - each is one 256 color tile */
+#define PARTICLE_TILE 16
+
+/* draw the four looks into the sprite tiles, in the copter's colors */
+void particles_setup(volatile unsigned short* sprite_tiles);
+
+/* get rid of every particle */
+void particles_clear( );
+
+/* throw out count particles from a point on the screen, in whole pixels */
+void particles_burst(int x, int y, int count, struct Random* random);
+
+/* move every particle along a frame, and burn them down */
+void particles_update( );
+
+/* write the particles into OAM entries, four halfwords each, newest first so
+ * the oldest are the ones left out when there is not room - returns the
+ * number drawn, the rest of the entries are hidden - nothing here limits
+ * them by scanline, the multiplexer's 64 sprites a band does that, and with
+ * them queued last and newest first it drops the oldest in a full band */
+int particles_draw(volatile unsigned short* oam, int slots);
+
+/* the number alive */
+int particles_count( );
+
+#endif
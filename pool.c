@@ -0,0 +1,59 @@
+/*
+ * pool.c
+ * allocator for lots of things the same size, like particles, out of an
+ * array the caller gives it - the free ones are kept in a list threaded
+ * through themselves, so taking or giving one back is a couple of loads
+ */
+
+#include <stddef.h>
+#include "pool.h"
+#include "profile.h"
+
+/* the bytes taken from every pool together, for the profiler */
+static unsigned int pool_bytes = 0;
+
+/* make a pool of count items of size bytes out of memory */
+void pool_init(struct Pool* pool, void* memory, int size, int count) {
+    pool->memory = memory;
+    pool->item_size = (size + 3) & ~3;
+    pool->capacity = count;
+    pool->used = 0;
+    pool->peak = 0;
+    pool_clear(pool);
+}
+
+/* take an item, returns NULL if they are all taken */
+void* pool_alloc(struct Pool* pool) {
+    void** item = pool->free;
+    if (item == NULL) {
+        return NULL;
+    }
+    pool->free = *item;
+    if (++pool->used > pool->peak) {
+        pool->peak = pool->used;
+    }
+    pool_bytes += pool->item_size;
+    profile_value(PROFILE_POOLS, pool_bytes);
+    return item;
+}
+
+/* give an item back */
+void pool_free(struct Pool* pool, void* item) {
+    *(void**) item = pool->free;
+    pool->free = item;
+    pool->used--;
+    pool_bytes -= pool->item_size;
+}
+
+/* give every item back at once, linking them in order so they are handed
+ * out from the start of the array */
+void pool_clear(struct Pool* pool) {
+    pool_bytes -= pool->used * pool->item_size;
+    pool->used = 0;
+    pool->free = NULL;
+    for (int i = pool->capacity - 1; i >= 0; i--) {
+        void** item = (void**) (pool->memory + i * pool->item_size);
+        *item = pool->free;
+        pool->free = item;
+    }
+}
@@ -0,0 +1,39 @@
+/*
+ * pool.h
+ * allocator for lots of things the same size, like particles, out of an
+ * array the caller gives it - the free ones are kept in a list threaded
+ * through themselves, so taking or giving one back is a couple of loads
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+/* one pool, the array is usually a global so it is in IWRAM */
+struct Pool {
+    /* the start of the array, and the first free item */
+    unsigned char* memory;
+    void* free;
+
+    /* the size of each item, rounded up to a word, and how many there are */
+    unsigned short item_size;
+    unsigned short capacity;
+
+    /* how many are taken now, and the most there have been */
+    unsigned short used;
+    unsigned short peak;
+};
+
+/* make a pool of count items of size bytes out of memory, which must be
+ * word aligned and hold count items rounded up to a word each */
+void pool_init(struct Pool* pool, void* memory, int size, int count);
+
+/* take an item, returns NULL if they are all taken */
+void* pool_alloc(struct Pool* pool);
+
+/* give an item back */
+void pool_free(struct Pool* pool, void* item);
+
+/* give every item back at once */
+void pool_clear(struct Pool* pool);
+
+#endif
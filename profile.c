@@ -0,0 +1,99 @@
+/*
+ * profile.c
+ * cycle counting profiler built on timers 2 and 3 cascaded together, which
+ * keeps the last and peak reading for each thing being measured
+ */
+
+#include "profile.h"
+
+/* timer 2 counts cycles and timer 3 counts each time timer 2 overflows */
+static volatile unsigned short* timer2_data = (volatile unsigned short*) 0x4000108;
+static volatile unsigned short* timer2_control = (volatile unsigned short*) 0x400010a;
+static volatile unsigned short* timer3_data = (volatile unsigned short*) 0x400010c;
+static volatile unsigned short* timer3_control = (volatile unsigned short*) 0x400010e;
+
+/* flags for the timer control registers */
+#define TIMER_CASCADE 0x0004
+#define TIMER_ENABLE 0x0080
+
+/* the readings for each slot */
+static unsigned int started[PROFILE_SLOTS];
+static unsigned int last[PROFILE_SLOTS];
+static unsigned int peak[PROFILE_SLOTS];
+
+/* where the readings are left for debugging tools */
+static volatile struct ProfileDebug* debug = (volatile struct ProfileDebug*) PROFILE_DEBUG_ADDRESS;
+
+/* start the timers, they count every CPU cycle from then on */
+void profile_init( ) {
+    *timer2_control = 0;
+    *timer3_control = 0;
+    *timer2_data = 0;
+    *timer3_data = 0;
+    *timer3_control = TIMER_CASCADE | TIMER_ENABLE;
+    *timer2_control = TIMER_ENABLE;
+    profile_reset();
+
+    debug->frames = 0;
+    debug->magic = PROFILE_DEBUG_MAGIC;
+}
+
+/* the number of cycles since profile_init - the high half is read on both
+ * sides of the low half in case timer 2 overflows in between */
+unsigned int profile_now( ) {
+    unsigned int high, low;
+    do {
+        high = *timer3_data;
+        low = *timer2_data;
+    } while (high != *timer3_data);
+    return (high << 16) | low;
+}
+
+/* mark the start of something being timed */
+void profile_begin(int slot) {
+    started[slot] = profile_now();
+}
+
+/* mark the end of something being timed */
+void profile_end(int slot) {
+    profile_value(slot, profile_now() - started[slot]);
+}
+
+/* record a value that is not a time, such as a number of bytes in use */
+void profile_value(int slot, unsigned int value) {
+    last[slot] = value;
+    if (value > peak[slot]) {
+        peak[slot] = value;
+    }
+}
+
+/* the last reading in a slot */
+unsigned int profile_last(int slot) {
+    return last[slot];
+}
+
+/* the largest reading in a slot */
+unsigned int profile_peak(int slot) {
+    return peak[slot];
+}
+
+/* copy the readings to the debug area, once a frame after the frame slot
+ * has been timed - the count goes up last, so a reader who sees it change
+ * knows the rest is there */
+void profile_frame( ) {
+    unsigned int frames = debug->frames;
+    debug->history[frames % PROFILE_DEBUG_HISTORY] = last[PROFILE_FRAME];
+    for (int i = 0; i < PROFILE_SLOTS; i++) {
+        debug->last[i] = last[i];
+        debug->peak[i] = peak[i];
+    }
+    debug->frames = frames + 1;
+}
+
+/* forget the peaks, for instance when a new scene starts */
+void profile_reset( ) {
+    for (int i = 0; i < PROFILE_SLOTS; i++) {
+        last[i] = 0;
+        peak[i] = 0;
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * profile.h
+ * cycle counting profiler built on timers 2 and 3 cascaded together, which
+ * keeps the last and peak reading for each thing being measured
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/* the things we measure, each gets its own slot */
+enum ProfileSlot {
+    PROFILE_FRAME,
+    PROFILE_MIXER,
+    PROFILE_MUSIC,
+    PROFILE_PARTICLES,
+
+    /* bytes in use in the EWRAM arena and in all the pools together */
+    PROFILE_ARENA,
+    PROFILE_POOLS,
+
+    /* VRAM claims which ran over another, always 0 without VRAM_CHECK */
+    PROFILE_VRAM,
+    PROFILE_SLOTS
+};
+
+/* there are 280896 cycles in a frame, 1232 per scanline */
+#define PROFILE_FRAME_CYCLES 280896
+#define PROFILE_LINE_CYCLES 1232
+
+/* each frame's time is also left in the last 256 bytes of EWRAM, where
+ * tools running the game in an emulator (tools/frametime.c) can read it */
+#define PROFILE_DEBUG_ADDRESS 0x203ff00
+#define PROFILE_DEBUG_MAGIC 0x464f5250
+#define PROFILE_DEBUG_HISTORY 8
+
+struct ProfileDebug {
+    /* PROFILE_DEBUG_MAGIC once profile_init has run */
+    unsigned int magic;
+
+    /* the number of frames recorded, and the frame slot's time for the last
+     * few of them, frame n going in history[n % PROFILE_DEBUG_HISTORY] */
+    unsigned int frames;
+    unsigned int history[PROFILE_DEBUG_HISTORY];
+
+    /* the last and peak readings of every slot as of the last frame */
+    unsigned int last[PROFILE_SLOTS];
+    unsigned int peak[PROFILE_SLOTS];
+};
+
+/* start the timers, they count every CPU cycle from then on */
+void profile_init( );
+
+/* the number of cycles since profile_init */
+unsigned int profile_now( );
+
+/* mark the start and end of something being timed */
+void profile_begin(int slot);
+void profile_end(int slot);
+
+/* record a value that is not a time, such as a number of bytes in use */
+void profile_value(int slot, unsigned int value);
+
+/* the last and the largest reading in a slot */
+unsigned int profile_last(int slot);
+unsigned int profile_peak(int slot);
+
+/* copy the readings to the debug area, once a frame after the frame slot
+ * has been timed */
+void profile_frame( );
+
+/* forget the peaks, for instance when a new scene starts */
+void profile_reset( );
+
+#endif
@@ -0,0 +1,177 @@
+/*
+ * psg.c
+ * music sequencer which plays tracker style patterns on the old sound chip
+ * channels (two squares, wave and noise), stepping once per vblank
+ */
+
+#include <stddef.h>
+#include "psg.h"
+#include "profile.h"
+
+/* the sound chip registers run from 0x4000060 to 0x400007e, and are kept
+ * track of here by their halfword offset from the start */
+static volatile unsigned short* psg_registers = (volatile unsigned short*) 0x4000060;
+#define PSG_REGISTERS 16
+#define SQUARE1_SWEEP 0
+#define SQUARE1_ENVELOPE 1
+#define SQUARE1_FREQUENCY 2
+#define SQUARE2_ENVELOPE 4
+#define SQUARE2_FREQUENCY 6
+#define WAVE_CONTROL 8
+#define WAVE_VOLUME 9
+#define WAVE_FREQUENCY 10
+#define NOISE_ENVELOPE 12
+#define NOISE_FREQUENCY 14
+
+/* the envelope (or volume) and frequency register of each channel */
+static const unsigned char envelope_register[PSG_CHANNELS] = {
+    SQUARE1_ENVELOPE, SQUARE2_ENVELOPE, WAVE_VOLUME, NOISE_ENVELOPE
+};
+static const unsigned char frequency_register[PSG_CHANNELS] = {
+    SQUARE1_FREQUENCY, SQUARE2_FREQUENCY, WAVE_FREQUENCY, NOISE_FREQUENCY
+};
+
+/* writing this bit to a frequency register starts a new note */
+#define PSG_TRIGGER 0x8000
+
+/* the wave channel plays the bank it is not being written through, so the
+ * shape is written with bank 1 selected and then bank 0 is played */
+#define WAVE_BANK1 0x0040
+#define WAVE_ENABLE 0x0080
+static volatile unsigned short* wave_ram = (volatile unsigned short*) 0x4000090;
+
+/* the mixing registers, shared with direct sound in mixer.c */
+static volatile unsigned short* sound_psg = (volatile unsigned short*) 0x4000080;
+static volatile unsigned short* sound_direct = (volatile unsigned short*) 0x4000082;
+static volatile unsigned short* sound_master = (volatile unsigned short*) 0x4000084;
+
+/* all four channels at full volume out of both speakers, mixed in at half
+ * volume so the sound effects stand out over the music */
+#define PSG_ALL_BOTH 0xff77
+#define PSG_HALF 0x0001
+#define PSG_RATIO_MASK 0x0003
+#define SOUND_MASTER_ENABLE 0x0080
+
+/* the frequency register values for C2 to B7 on the square channels, which
+ * play 131072 / (2048 - value) hz */
+static const unsigned short note_frequency[PSG_NOTES] = {
+    44, 156, 263, 363, 457, 547, 631, 711, 786, 856, 923, 986,
+    1046, 1102, 1155, 1205, 1253, 1297, 1339, 1379, 1417, 1452, 1486, 1517,
+    1547, 1575, 1602, 1627, 1650, 1673, 1694, 1714, 1732, 1750, 1767, 1783,
+    1798, 1812, 1825, 1837, 1849, 1860, 1871, 1881, 1890, 1899, 1907, 1915,
+    1923, 1930, 1936, 1943, 1949, 1954, 1959, 1964, 1969, 1974, 1978, 1982,
+    1985, 1989, 1992, 1995, 1998, 2001, 2004, 2006, 2009, 2011, 2013, 2015,
+};
+
+/* what was last written to each register, so they are only written when
+ * something changes */
+static unsigned short shadow[PSG_REGISTERS];
+
+/* the song playing, where we are in it and the frames left of this row */
+static const struct Song* volatile song = NULL;
+static int position = 0;
+static int timer = 0;
+
+/* write a register, unless it already holds the value */
+static void psg_set(int reg, unsigned short value) {
+    if (shadow[reg] != value) {
+        shadow[reg] = value;
+        psg_registers[reg] = value;
+    }
+}
+
+/* silence every channel */
+static void psg_silence( ) {
+    for (int channel = 0; channel < PSG_CHANNELS; channel++) {
+        psg_set(envelope_register[channel], 0);
+    }
+}
+
+/* turn on the sound chip channels, after mixer_init which sets up the rest */
+void psg_init( ) {
+    song = NULL;
+    *sound_master = SOUND_MASTER_ENABLE;
+    *sound_psg = PSG_ALL_BOTH;
+    *sound_direct = (*sound_direct & ~PSG_RATIO_MASK) | PSG_HALF;
+
+    /* no sweep on square 1, and everything else quiet */
+    for (int i = 0; i < PSG_REGISTERS; i++) {
+        shadow[i] = 0;
+        psg_registers[i] = 0;
+    }
+    psg_set(SQUARE1_SWEEP, 0x0008);
+}
+
+/* start playing a song from the top, or stop the music with NULL */
+void psg_play(const struct Song* next) {
+    /* stop the interrupt looking at the old song while this one is set up */
+    song = NULL;
+    psg_silence();
+    if (next == NULL) {
+        return;
+    }
+
+    /* load the wave shape with the wave channel off */
+    psg_set(WAVE_CONTROL, WAVE_BANK1);
+    for (int i = 0; i < 8; i++) {
+        wave_ram[i] = next->wave_shape[i * 2] | (next->wave_shape[i * 2 + 1] << 8);
+    }
+    psg_set(WAVE_CONTROL, WAVE_ENABLE);
+
+    /* the first row plays on the next vblank */
+    position = 0;
+    timer = 1;
+    song = next;
+}
+
+/* start a note on a channel, or stop it */
+static void psg_note(const struct Song* playing, int channel, int note) {
+    if (note == PSG_NOTE_OFF) {
+        psg_set(envelope_register[channel], 0);
+        return;
+    }
+
+    psg_set(envelope_register[channel], playing->envelope[channel]);
+
+    /* noise notes are the raw noise settings, the others look up a pitch */
+    unsigned short frequency;
+    if (channel == PSG_NOISE) {
+        frequency = note - 1;
+    } else if (note <= PSG_NOTES) {
+        frequency = note_frequency[note - 1];
+    } else {
+        return;
+    }
+
+    /* a new note has to be triggered even if it is the same as the last */
+    int reg = frequency_register[channel];
+    shadow[reg] = frequency;
+    psg_registers[reg] = frequency | PSG_TRIGGER;
+}
+
+/* move the song on a frame, this must be called from the vblank interrupt */
+void psg_vblank( ) {
+    const struct Song* playing = song;
+    if (playing == NULL || --timer > 0) {
+        return;
+    }
+    profile_begin(PROFILE_MUSIC);
+    timer = playing->speed;
+
+    /* read the next row, going round to the loop point at the end */
+    const unsigned char* rows = playing->rows;
+    int channels = rows[position++];
+    if (channels == PSG_END) {
+        position = playing->loop;
+        channels = rows[position++];
+    }
+
+    /* a note for each channel with its bit set, most rows have none */
+    for (int channel = 0; channels; channel++, channels >>= 1) {
+        if (channels & 1) {
+            psg_note(playing, channel, rows[position++]);
+        }
+    }
+
+    profile_end(PROFILE_MUSIC);
+}
@@ -0,0 +1,57 @@
+/*
+ * psg.h
+ * music sequencer which plays tracker style patterns on the old sound chip
+ * channels (two squares, wave and noise), stepping once per vblank
+ */
+
+#ifndef PSG_H
+#define PSG_H
+
+/* the four sound chip channels, one column each in a pattern */
+#define PSG_SQUARE1 0
+#define PSG_SQUARE2 1
+#define PSG_WAVE 2
+#define PSG_NOISE 3
+#define PSG_CHANNELS 4
+
+/* the song is a list of rows, each one a byte with a bit set for each channel
+ * that does something on that row followed by a byte for each of them - 0
+ * stops the channel's note, anything else starts a new one */
+#define PSG_NOTE_OFF 0
+
+/* a row byte of this sends the song back to its loop point */
+#define PSG_END 0xff
+
+/* notes on the tonal channels count up in semitones from C2 at 1, the wave
+ * channel playing an octave below the squares for the same note, and noise
+ * notes are the value for the noise control register plus one */
+#define PSG_NOTES 72
+
+/* a song made by the mus2gba tool from a text file in music/ */
+struct Song {
+    /* the rows, and the offset into them the song goes back to at the end */
+    const unsigned char* rows;
+    unsigned short loop;
+
+    /* how many frames each row lasts */
+    unsigned short speed;
+
+    /* what each channel's envelope register is set to for a note - the duty
+     * and envelope bits for the squares, the volume bits for the wave
+     * channel and the envelope bits for noise */
+    unsigned short envelope[PSG_CHANNELS];
+
+    /* 32 4 bit samples for the wave channel, two to a byte */
+    const unsigned char* wave_shape;
+};
+
+/* turn on the sound chip channels, after mixer_init which sets up the rest */
+void psg_init( );
+
+/* start playing a song from the top, or stop the music with NULL */
+void psg_play(const struct Song* song);
+
+/* move the song on a frame, this must be called from the vblank interrupt */
+void psg_vblank( );
+
+#endif
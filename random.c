@@ -0,0 +1,86 @@
+/*
+ * random.c
+ * small xorshift random number generator with an explicit state, so the
+ * same seed gives the same numbers on the cartridge and on the host
+ */
+
+#include "random.h"
+
+/* xorshift can never leave zero, so a zero seed is swapped for this */
+#define RANDOM_DEFAULT_SEED 0x2545f491
+
+/* one step of xorshift32 - each line is a single ARM instruction since the
+ * barrel shifter does the shift for free, and inlined the state stays in a
+ * register */
+static inline unsigned int random_step(unsigned int x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+/* start a generator from a seed, any value including zero is fine */
+void random_seed(struct Random* random, unsigned int seed) {
+    random->state = seed ? seed : RANDOM_DEFAULT_SEED;
+}
+
+/* mix some entropy (a frame count, a button timing) into the state */
+void random_stir(struct Random* random, unsigned int entropy) {
+    unsigned int x = random->state ^ (entropy * 0x9e3779b9);
+    if (x == 0) {
+        x = RANDOM_DEFAULT_SEED;
+    }
+    x = random_step(x);
+    random->state = x;
+}
+
+/* the next 32 random bits */
+unsigned int random_next(struct Random* random) {
+    unsigned int x = random->state;
+    x = random_step(x);
+    random->state = x;
+    return x;
+}
+
+/* a random number from 0 to range - 1, the top 16 bits are scaled with a
+ * multiply and shift since the GBA has no divide instruction */
+int random_range(struct Random* random, int range) {
+    return (int) (((random_next(random) >> 16) * (unsigned int) range) >> 16);
+}
+
+/* a random number from low to high, including both ends */
+int random_between(struct Random* random, int low, int high) {
+    return low + random_range(random, high - low + 1);
+}
+
+/* fill an array with random words, keeping the state in a register */
+void random_fill(struct Random* random, unsigned int* dest, int count) {
+    unsigned int x = random->state;
+    for (int i = 0; i < count; i++) {
+        x = random_step(x);
+        dest[i] = x;
+    }
+    random->state = x;
+}
+
+/* fill an array with random bytes, four from each step */
+void random_fill_bytes(struct Random* random, unsigned char* dest, int count) {
+    unsigned int x = random->state;
+    int i = 0;
+    while (i + 4 <= count) {
+        x = random_step(x);
+        dest[i++] = x;
+        dest[i++] = x >> 8;
+        dest[i++] = x >> 16;
+        dest[i++] = x >> 24;
+    }
+    if (i < count) {
+        x = random_step(x);
+        unsigned int bits = x;
+        while (i < count) {
+            dest[i++] = bits;
+            bits >>= 8;
+        }
+    }
+    random->state = x;
+}
@@ -0,0 +1,34 @@
+/*
+ * random.h
+ * small xorshift random number generator with an explicit state, so the
+ * same seed gives the same numbers on the cartridge and on the host
+ */
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+/* the state of one generator, give each system its own to keep them apart */
+struct Random {
+    unsigned int state;
+};
+
+/* start a generator from a seed, any value including zero is fine */
+void random_seed(struct Random* random, unsigned int seed);
+
+/* mix some entropy (a frame count, a button timing) into the state */
+void random_stir(struct Random* random, unsigned int entropy);
+
+/* the next 32 random bits */
+unsigned int random_next(struct Random* random);
+
+/* a random number from 0 to range - 1, range can be at most 65536 */
+int random_range(struct Random* random, int range);
+
+/* a random number from low to high, including both ends */
+int random_between(struct Random* random, int low, int high);
+
+/* fill an array with random words or bytes */
+void random_fill(struct Random* random, unsigned int* dest, int count);
+void random_fill_bytes(struct Random* random, unsigned char* dest, int count);
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * render.c
+ * render queue which puts a frame's sprites in depth order - each one is
+ * queued with a depth, and a radix sort writes them out nearest first, which
+ * is the order OAM draws them in, in the same number of steps every frame
+ */
+
+#include <stddef.h>
+#include "render.h"
+
+/* the sprites queued this frame and their depths */
+static const unsigned short* entries[RENDER_MAX];
+static unsigned char depths[RENDER_MAX];
+static int count = 0;
+
+/* the sort goes a digit of 4 bits at a time, the low one then the high */
+#define RENDER_RADIX 16
+
+/* start a new frame with nothing queued */
+void render_begin( ) {
+    count = 0;
+}
+
+/* queue a sprite, returns 0 if the queue is full */
+int render_add(const unsigned short* entry, int depth) {
+    if (count == RENDER_MAX) {
+        return 0;
+    }
+    entries[count] = entry;
+    depths[count] = depth;
+    count++;
+    return 1;
+}
+
+/* one pass of the sort - count each digit, turn the counts into where each
+ * digit starts, then move everything there in order, which keeps it stable */
+static void render_pass(const unsigned char* order, unsigned char* sorted, int shift) {
+    unsigned short starts[RENDER_RADIX + 1] = {0};
+    for (int i = 0; i < count; i++) {
+        starts[((depths[order[i]] >> shift) & (RENDER_RADIX - 1)) + 1]++;
+    }
+    for (int digit = 1; digit <= RENDER_RADIX; digit++) {
+        starts[digit] += starts[digit - 1];
+    }
+    for (int i = 0; i < count; i++) {
+        sorted[starts[(depths[order[i]] >> shift) & (RENDER_RADIX - 1)]++] = order[i];
+    }
+}
+
+/* sort what was queued and write it to shadow, four halfwords a sprite -
+ * the sort moves indices, which fit in a byte, and each sprite is copied
+ * once at the end */
+int render_end(unsigned short* shadow) {
+    unsigned char order[RENDER_MAX], sorted[RENDER_MAX];
+    for (int i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    render_pass(order, sorted, 0);
+    render_pass(sorted, order, 4);
+
+    for (int i = 0; i < count; i++) {
+        const unsigned short* entry = entries[order[i]];
+        shadow[i * 4] = entry[0];
+        shadow[i * 4 + 1] = entry[1];
+        shadow[i * 4 + 2] = entry[2];
+        shadow[i * 4 + 3] = entry[3];
+    }
+    return count;
+}
@@ -0,0 +1,32 @@
+/*
+ * render.h
+ * render queue which puts a frame's sprites in depth order - each one is
+ * queued with a depth, and a radix sort writes them out nearest first, which
+ * is the order OAM draws them in, in the same number of steps every frame
+ */
+
+#ifndef RENDER_H
+#define RENDER_H
+
+/* the most sprites queued in a frame */
+#define RENDER_MAX 256
+
+/* depths go from 0, in front of everything, to 255 at the back - sprites
+ * at the same depth keep the order they were queued in - the multiplexer
+ * keeps this order only among sprites starting in the same band, and where
+ * sprites from neighbouring bands overlap the one in the even band is drawn
+ * in front whatever its depth, see mux.h */
+#define RENDER_DEPTHS 256
+
+/* start a new frame with nothing queued */
+void render_begin( );
+
+/* queue a sprite, an OAM entry of four halfwords which must stay put until
+ * render_end - returns 0 if the queue is full */
+int render_add(const unsigned short* entry, int depth);
+
+/* sort what was queued and write it to shadow, four halfwords a sprite,
+ * returns the number written */
+int render_end(unsigned short* shadow);
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * replay.c
+ * records the buttons of each run as run length encoded bytes, and plays
+ * them back to drive a ghost copter
+ */
+
+#include "replay.h"
+#include "input.h"
+
+/* start recording into a buffer */
+void replay_record_start(struct Replay* replay, unsigned char* buffer, int capacity, unsigned int seed) {
+    replay->seed = seed;
+    replay->score = 0;
+    replay->frames = 0;
+    replay->runs = buffer;
+    replay->length = 0;
+    replay->capacity = capacity;
+    replay_play_start(replay);
+}
+
+/* add one frame of buttons, returns 0 once the buffer is full - only UP
+ * matters to the copter, so it is the only button kept */
+int replay_record(struct Replay* replay, unsigned short keys) {
+    unsigned char key = (keys & BUTTON_UP) ? REPLAY_KEY_BIT : 0;
+
+    /* lengthen the last run if it is the same button and not full yet */
+    if (replay->length > 0) {
+        unsigned char* last = &replay->runs[replay->length - 1];
+        if ((*last & REPLAY_KEY_BIT) == key && (*last & ~REPLAY_KEY_BIT) < REPLAY_RUN_MAX - 1) {
+            (*last)++;
+            replay->frames++;
+            return 1;
+        }
+    }
+
+    /* otherwise start a new run of one frame */
+    if (replay->length >= replay->capacity) {
+        return 0;
+    }
+    replay->runs[replay->length++] = key;
+    replay->frames++;
+    return 1;
+}
+
+/* rewind to the start for playing back */
+void replay_play_start(struct Replay* replay) {
+    replay->position = 0;
+    replay->count = 0;
+    replay->keys = 0;
+}
+
+/* the buttons for the next frame of playback - most frames just count down
+ * the current run, a new byte is only read when it runs out */
+unsigned short replay_play(struct Replay* replay) {
+    if (replay->count == 0) {
+        if (replay->position >= replay->length) {
+            return 0;
+        }
+        unsigned char run = replay->runs[replay->position++];
+        replay->count = (run & ~REPLAY_KEY_BIT) + 1;
+        replay->keys = (run & REPLAY_KEY_BIT) ? BUTTON_UP : 0;
+    }
+    replay->count--;
+    return replay->keys;
+}
+
+/* returns whether playback has run out of frames */
+int replay_done(struct Replay* replay) {
+    return replay->count == 0 && replay->position >= replay->length;
+}
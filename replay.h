@@ -0,0 +1,51 @@
+/*
+ * replay.h
+ * records the buttons of each run as run length encoded bytes, and plays
+ * them back to drive a ghost copter
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+/* each byte of a replay is one run - the top bit is whether UP was held and
+ * the low 7 bits are the number of frames minus one, so one byte covers up
+ * to 128 frames */
+#define REPLAY_KEY_BIT 0x80
+#define REPLAY_RUN_MAX 128
+
+/* a recorded run, and where we are in recording or playing it */
+struct Replay {
+    /* the seed of the cave the run was flown in, and its score */
+    unsigned int seed;
+    unsigned int score;
+
+    /* the number of frames recorded */
+    unsigned int frames;
+
+    /* the encoded runs, how many bytes are used and how many fit */
+    unsigned char* runs;
+    int length;
+    int capacity;
+
+    /* the next byte to play, and frames left of the run being played */
+    int position;
+    int count;
+    unsigned short keys;
+};
+
+/* start recording into a buffer */
+void replay_record_start(struct Replay* replay, unsigned char* buffer, int capacity, unsigned int seed);
+
+/* add one frame of buttons, returns 0 once the buffer is full */
+int replay_record(struct Replay* replay, unsigned short keys);
+
+/* rewind to the start for playing back */
+void replay_play_start(struct Replay* replay);
+
+/* the buttons for the next frame of playback */
+unsigned short replay_play(struct Replay* replay);
+
+/* returns whether playback has run out of frames */
+int replay_done(struct Replay* replay);
+
+#endif
@@ -0,0 +1,363 @@
+/*
+ * save.c
+ * high scores and settings kept in battery backed cartridge SRAM, written
+ * as two checksummed copies so a write cut off by power loss never leaves
+ * us without a good record
+ */
+
+#include <stddef.h>
+#include "save.h"
+
+#ifdef HOST_BUILD
+#include <stdio.h>
+#include <string.h>
+#endif
+
+/* SRAM is 32K and only has an 8 bit bus, so it is always read and written
+ * one byte at a time through an unsigned char pointer */
+#define SRAM_SIZE 0x8000
+
+#ifdef HOST_BUILD
+static unsigned char sram_memory[SRAM_SIZE];
+static volatile unsigned char* sram = sram_memory;
+#else
+static volatile unsigned char* sram = (volatile unsigned char*) 0x0E000000;
+#endif
+
+/* emulators and flash carts look for this string to know we use SRAM */
+const char save_type[] = "SRAM_V113";
+
+/* "HELI" at the start of each good record */
+#define SAVE_MAGIC 0x494c4548
+
+/* the two copies live at the start of SRAM, one slot each */
+#define SAVE_SLOTS 2
+#define SAVE_SLOT_SIZE 256
+
+/* the header at the start of each slot, followed by the SaveData */
+struct SaveHeader {
+    unsigned int magic;
+    unsigned short version;
+    unsigned short length;
+    unsigned int sequence;
+    unsigned short crc;
+    unsigned short reserved;
+};
+
+/* a whole slot, the header followed by the SaveData */
+struct SaveRecord {
+    struct SaveHeader header;
+    struct SaveData data;
+};
+
+#define SAVE_HEADER_SIZE ((int) sizeof(struct SaveHeader))
+#define SAVE_DATA_SIZE ((int) sizeof(struct SaveData))
+#define SAVE_RECORD_SIZE ((int) sizeof(struct SaveRecord))
+
+/* the ghost replay goes after the two slots, a header and then the runs */
+#define SAVE_REPLAY_OFFSET 0x200
+#define SAVE_REPLAY_DATA (SAVE_REPLAY_OFFSET + 0x20)
+
+/* "GHST" at the start of a good replay */
+#define SAVE_REPLAY_MAGIC 0x54534847
+
+/* the header of the replay, its checksum covers the fields after the magic
+ * up to the checksum itself, then the runs */
+struct SaveReplayHeader {
+    unsigned int magic;
+    unsigned int seed;
+    unsigned int score;
+    unsigned int frames;
+    unsigned short length;
+    unsigned short crc;
+};
+
+#define SAVE_REPLAY_HEADER_SIZE ((int) sizeof(struct SaveReplayHeader))
+#define SAVE_REPLAY_CHECKED 14
+
+/* the slot holding the newest good record, or -1 if there is none */
+static int active_slot = -1;
+static unsigned int active_sequence = 0;
+
+/* the record being written, which slot it goes to and how far along it is */
+static struct SaveRecord staged;
+static int staged_slot = -1;
+static int staged_position = 0;
+
+/* the replay being written, its header, and how far along it is - the
+ * first step marks the old replay bad, then the runs go, then the header */
+static struct SaveReplayHeader replay_header;
+static const unsigned char* replay_source = NULL;
+static int replay_position = 0;
+static unsigned short replay_crc = 0;
+
+/* CRC-16-CCITT a nibble at a time, which needs only a 16 entry table */
+static const unsigned short crc_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+};
+
+static unsigned short crc16(unsigned short crc, const unsigned char* data, int length) {
+    for (int i = 0; i < length; i++) {
+        crc = (crc << 4) ^ crc_table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ crc_table[(crc >> 12) ^ (data[i] & 0x0f)];
+    }
+    return crc;
+}
+
+/* the checksum covers everything in the record except the magic and itself */
+static unsigned short record_crc(const struct SaveRecord* record) {
+    const unsigned char* bytes = (const unsigned char*) record;
+    unsigned short crc = crc16(0xffff, bytes + 4, 8);
+    return crc16(crc, bytes + SAVE_HEADER_SIZE, SAVE_DATA_SIZE);
+}
+
+/* copy a whole slot out of SRAM */
+static void read_slot(int slot, struct SaveRecord* record) {
+    volatile unsigned char* source = sram + slot * SAVE_SLOT_SIZE;
+    unsigned char* dest = (unsigned char*) record;
+    for (int i = 0; i < SAVE_RECORD_SIZE; i++) {
+        dest[i] = source[i];
+    }
+}
+
+/* returns whether a record read out of a slot is good */
+static int record_valid(const struct SaveRecord* record) {
+    return record->header.magic == SAVE_MAGIC &&
+        record->header.version == SAVE_VERSION &&
+        record->header.length == SAVE_DATA_SIZE &&
+        record->header.crc == record_crc(record);
+}
+
+/* the settings and scores a new cartridge starts with */
+static void save_defaults(struct SaveData* data) {
+    for (int i = 0; i < SAVE_SCORES; i++) {
+        data->scores[i] = 0;
+    }
+    data->sound = 1;
+    data->music = 1;
+    data->ghost = 1;
+    data->reserved = 0;
+}
+
+/* read the newest good record, returns 0 and fills in defaults if none */
+int save_load(struct SaveData* data) {
+    struct SaveRecord record;
+
+    active_slot = -1;
+    for (int slot = 0; slot < SAVE_SLOTS; slot++) {
+        read_slot(slot, &record);
+        if (!record_valid(&record)) {
+            continue;
+        }
+
+        /* keep the newer of the two, allowing for the sequence wrapping */
+        if (active_slot < 0 || (int) (record.header.sequence - active_sequence) > 0) {
+            active_slot = slot;
+            active_sequence = record.header.sequence;
+            *data = record.data;
+        }
+    }
+
+    if (active_slot < 0) {
+        save_defaults(data);
+        return 0;
+    }
+    return 1;
+}
+
+/* put a score into the table, returns its rank or -1 if it did not make it */
+int save_insert_score(struct SaveData* data, unsigned int score) {
+    int rank = SAVE_SCORES;
+    while (rank > 0 && data->scores[rank - 1] < score) {
+        rank--;
+    }
+    if (rank == SAVE_SCORES) {
+        return -1;
+    }
+
+    /* shuffle the lower scores down to make room */
+    for (int i = SAVE_SCORES - 1; i > rank; i--) {
+        data->scores[i] = data->scores[i - 1];
+    }
+    data->scores[rank] = score;
+    return rank;
+}
+
+/* start writing a record, the actual writes happen in save_step - it always
+ * goes to the slot not holding the newest good record */
+void save_begin(const struct SaveData* data) {
+    if (staged_slot < 0) {
+        staged_slot = (active_slot == 0) ? 1 : 0;
+    }
+
+    staged.header.magic = SAVE_MAGIC;
+    staged.header.version = SAVE_VERSION;
+    staged.header.length = SAVE_DATA_SIZE;
+    staged.header.sequence = active_sequence + 1;
+    staged.header.reserved = 0;
+    staged.data = *data;
+    staged.header.crc = record_crc(&staged);
+
+    staged_position = 0;
+}
+
+/* read the saved ghost replay into a buffer, returns 0 if there is no good one */
+int save_load_replay(struct Replay* replay, unsigned char* buffer, int capacity) {
+    struct SaveReplayHeader header;
+    unsigned char* bytes = (unsigned char*) &header;
+    for (int i = 0; i < SAVE_REPLAY_HEADER_SIZE; i++) {
+        bytes[i] = sram[SAVE_REPLAY_OFFSET + i];
+    }
+    if (header.magic != SAVE_REPLAY_MAGIC || header.length > capacity) {
+        return 0;
+    }
+
+    /* copy the runs out, checking them as we go */
+    unsigned short crc = crc16(0xffff, bytes + 4, SAVE_REPLAY_CHECKED);
+    for (int i = 0; i < header.length; i++) {
+        buffer[i] = sram[SAVE_REPLAY_DATA + i];
+    }
+    crc = crc16(crc, buffer, header.length);
+    if (crc != header.crc) {
+        return 0;
+    }
+
+    replay_record_start(replay, buffer, capacity, header.seed);
+    replay->score = header.score;
+    replay->frames = header.frames;
+    replay->length = header.length;
+    return 1;
+}
+
+/* start writing a ghost replay, the actual writes happen in save_step */
+void save_begin_replay(const struct Replay* replay) {
+    replay_header.magic = SAVE_REPLAY_MAGIC;
+    replay_header.seed = replay->seed;
+    replay_header.score = replay->score;
+    replay_header.frames = replay->frames;
+    replay_header.length = replay->length;
+    replay_header.crc = 0;
+
+    replay_source = replay->runs;
+    replay_position = 0;
+    replay_crc = crc16(0xffff, (const unsigned char*) &replay_header + 4, SAVE_REPLAY_CHECKED);
+}
+
+/* write up to budget bytes of the pending replay, returns the budget left */
+static int step_replay(int budget) {
+    if (!replay_source) {
+        return budget;
+    }
+
+    int length = replay_header.length;
+    const unsigned char* header = (const unsigned char*) &replay_header;
+    while (budget > 0) {
+        if (replay_position == 0) {
+            /* spoil the magic so a replay cut off halfway is never used */
+            sram[SAVE_REPLAY_OFFSET] = 0;
+        } else if (replay_position <= length) {
+            /* the runs, checksummed as they go by */
+            int i = replay_position - 1;
+            replay_crc = crc16(replay_crc, replay_source + i, 1);
+            if (sram[SAVE_REPLAY_DATA + i] != replay_source[i]) {
+                sram[SAVE_REPLAY_DATA + i] = replay_source[i];
+            }
+        } else {
+            /* then the header, with the magic going in last */
+            int offset = replay_position - length - 1 + 4;
+            if (offset >= SAVE_REPLAY_HEADER_SIZE) {
+                offset -= SAVE_REPLAY_HEADER_SIZE;
+            }
+            replay_header.crc = replay_crc;
+            sram[SAVE_REPLAY_OFFSET + offset] = header[offset];
+            if (offset == 3) {
+                replay_source = NULL;
+                return budget - 1;
+            }
+        }
+        replay_position++;
+        budget--;
+    }
+    return budget;
+}
+
+/* write up to budget bytes of the pending record, returns the budget left -
+ * the data goes first and the header last, and only bytes which differ from
+ * what is already in SRAM are written, since every access is slow */
+static int step_record(int budget) {
+    if (staged_slot < 0) {
+        return budget;
+    }
+
+    volatile unsigned char* dest = sram + staged_slot * SAVE_SLOT_SIZE;
+    const unsigned char* source = (const unsigned char*) &staged;
+    while (budget > 0 && staged_position < SAVE_RECORD_SIZE) {
+        int offset = staged_position + SAVE_HEADER_SIZE;
+        if (offset >= SAVE_RECORD_SIZE) {
+            offset -= SAVE_RECORD_SIZE;
+        }
+        if (dest[offset] != source[offset]) {
+            dest[offset] = source[offset];
+        }
+        staged_position++;
+        budget--;
+    }
+
+    if (staged_position < SAVE_RECORD_SIZE) {
+        return budget;
+    }
+
+    /* the slot we just finished is now the newest */
+    active_slot = staged_slot;
+    active_sequence = staged.header.sequence;
+    staged_slot = -1;
+    return budget;
+}
+
+/* write up to budget bytes of the pending record and then the pending
+ * replay, returns 1 while either is still busy */
+int save_step(int budget) {
+    budget = step_record(budget);
+    step_replay(budget);
+    return save_busy();
+}
+
+/* returns 1 while a record or replay is still being written */
+int save_busy( ) {
+    return staged_slot >= 0 || replay_source != NULL;
+}
+
+/* finish writing the pending record and replay right now */
+void save_flush( ) {
+    save_step(SAVE_RECORD_SIZE + SAVE_REPLAY_CAPACITY + SAVE_REPLAY_HEADER_SIZE + 1);
+}
+
+#ifdef HOST_BUILD
+/* the file standing in for SRAM on the host */
+static const char* host_path = NULL;
+
+/* on the host SRAM is emulated with a file, which is created if missing */
+int save_host_open(const char* path) {
+    host_path = path;
+    memset(sram_memory, 0xff, SRAM_SIZE);
+
+    FILE* file = fopen(path, "rb");
+    if (file) {
+        fread(sram_memory, 1, SRAM_SIZE, file);
+        fclose(file);
+    }
+    return 1;
+}
+
+/* write the emulated SRAM back out to its file */
+int save_host_close( ) {
+    FILE* file = fopen(host_path, "wb");
+    if (!file) {
+        return 0;
+    }
+    int written = fwrite(sram_memory, 1, SRAM_SIZE, file) == SRAM_SIZE;
+    fclose(file);
+    return written;
+}
+#endif
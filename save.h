@@ -0,0 +1,68 @@
+/*
+ * save.h
+ * high scores and settings kept in battery backed cartridge SRAM, written
+ * as two checksummed copies so a write cut off by power loss never leaves
+ * us without a good record
+ */
+
+#ifndef SAVE_H
+#define SAVE_H
+
+#include "replay.h"
+
+/* bump this whenever struct SaveData changes, old records are then ignored */
+#define SAVE_VERSION 1
+
+/* the number of high scores kept */
+#define SAVE_SCORES 5
+
+/* how many bytes save_step writes each frame by default */
+#define SAVE_STEP_BYTES 64
+
+/* the rest of SRAM after the records holds one ghost replay */
+#define SAVE_REPLAY_CAPACITY 32224
+
+/* everything that is saved */
+struct SaveData {
+    /* the high scores, best first */
+    unsigned int scores[SAVE_SCORES];
+
+    /* the player's settings, 1 is on and 0 is off */
+    unsigned char sound;
+    unsigned char music;
+    unsigned char ghost;
+    unsigned char reserved;
+};
+
+/* read the newest good record, returns 0 and fills in defaults if none */
+int save_load(struct SaveData* data);
+
+/* put a score into the table, returns its rank or -1 if it did not make it */
+int save_insert_score(struct SaveData* data, unsigned int score);
+
+/* start writing a record, the actual writes happen in save_step */
+void save_begin(const struct SaveData* data);
+
+/* read the saved ghost replay into a buffer, returns 0 if there is no good one */
+int save_load_replay(struct Replay* replay, unsigned char* buffer, int capacity);
+
+/* start writing a ghost replay, the actual writes happen in save_step - the
+ * runs must not change until it is done */
+void save_begin_replay(const struct Replay* replay);
+
+/* write up to budget bytes of the pending record, returns 1 while busy */
+int save_step(int budget);
+
+/* returns 1 while a record or replay is still being written */
+int save_busy( );
+
+/* finish writing the pending record and replay right now */
+void save_flush( );
+
+#ifdef HOST_BUILD
+/* on the host SRAM is emulated with a file, which is created if missing */
+int save_host_open(const char* path);
+int save_host_close( );
+#endif
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * scene.c
+ * game state machine where each scene (title, play, pause, game over) has
+ * enter, update and exit hooks and names the groups of assets it needs
+ */
+
+#include <stddef.h>
+#include "scene.h"
+#include "arena.h"
+
+/* the functions which upload each group of assets */
+static scene_hook loaders[SCENE_MAX_ASSETS];
+
+/* bit mask of the asset groups which are in VRAM right now */
+static unsigned int resident = 0;
+
+/* the scene that is running and the one we are switching to */
+static struct Scene* current = NULL;
+static struct Scene* pending = NULL;
+
+/* where the arena was up to when the first scene started, every change
+ * goes back to it */
+static unsigned int arena_base = 0;
+
+/* give the function which uploads one group of assets into VRAM */
+void scene_register_assets(int group, scene_hook load) {
+    loaders[group] = load;
+    resident &= ~(1 << group);
+}
+
+/* mark asset groups as no longer in VRAM, so they are loaded again */
+void scene_invalidate_assets(unsigned int groups) {
+    resident &= ~groups;
+}
+
+/* switch to a new scene at the start of the next scene_update */
+void scene_change(struct Scene* next) {
+    pending = next;
+}
+
+/* returns the scene currently running */
+struct Scene* scene_current( ) {
+    return current;
+}
+
+/* load any groups the next scene needs which are not already in VRAM, in
+ * group order - groups that stay resident are never uploaded twice */
+static void scene_load_assets(unsigned int needed) {
+    unsigned int missing = needed & ~resident;
+    for (int group = 0; missing != 0; group++, missing >>= 1) {
+        if ((missing & 1) && loaders[group]) {
+            loaders[group]();
+            resident |= 1 << group;
+        }
+    }
+}
+
+/* do any pending transition, then run one frame of the current scene */
+void scene_update( ) {
+    if (pending) {
+        struct Scene* next = pending;
+        pending = NULL;
+
+        if (current && current->exit) {
+            current->exit();
+        }
+
+        /* what the last scene allocated goes with it */
+        if (current) {
+            arena_reset(arena_base);
+        } else {
+            arena_base = arena_mark();
+        }
+        scene_load_assets(next->assets);
+        current = next;
+        if (current->enter) {
+            current->enter();
+        }
+    }
+
+    if (current && current->update) {
+        current->update();
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * scene.h
+ * game state machine where each scene (title, play, pause, game over) has
+ * enter, update and exit hooks and names the groups of assets it needs
+ */
+
+#ifndef SCENE_H
+#define SCENE_H
+
+/* the most asset groups the scenes can share, one bit each */
+#define SCENE_MAX_ASSETS 16
+
+/* a hook called by the state machine, any of them can be left NULL */
+typedef void (*scene_hook)( );
+
+/* one state of the game */
+struct Scene {
+    /* called once when the scene becomes current */
+    scene_hook enter;
+
+    /* called once per frame while the scene is current */
+    scene_hook update;
+
+    /* called once when we switch away from the scene */
+    scene_hook exit;
+
+    /* bit mask of the asset groups that must be in VRAM for this scene */
+    unsigned int assets;
+};
+
+/* give the function which uploads one group of assets into VRAM */
+void scene_register_assets(int group, scene_hook load);
+
+/* mark asset groups as no longer in VRAM, so they are loaded again */
+void scene_invalidate_assets(unsigned int groups);
+
+/* switch to a new scene at the start of the next scene_update - anything
+ * taken from the arena since the first scene started is freed, so what has
+ * to last from one scene to the next is allocated before that */
+void scene_change(struct Scene* next);
+
+/* returns the scene currently running */
+struct Scene* scene_current( );
+
+/* do any pending transition, then run one frame of the current scene */
+void scene_update( );
+
+#endif
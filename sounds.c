@@ -0,0 +1,85 @@
+/*
+ * sounds.c
+ * the game's sound effects, which are made up at start up instead of
+ * taking space in ROM
+ */
+
+#include "sounds.h"
+#include "random.h"
+
+/* the lengths of each sound, in samples at the mixer rate */
+#define ROTOR_LENGTH 1536
+#define CRASH_LENGTH 8192
+#define PICKUP_LENGTH 2048
+
+struct Sound rotor_sound;
+struct Sound crash_sound;
+struct Sound pickup_sound;
+
+/* one blade pass is a thump with some noise on it, dying away by halfway */
+static void make_rotor(signed char* data, struct Random* random) {
+    int phase = 0;
+    for (int i = 0; i < ROTOR_LENGTH; i++) {
+        int envelope = (i < ROTOR_LENGTH / 2) ? (ROTOR_LENGTH / 2 - i) >> 3 : 0;
+
+        /* a triangle wave of about 110 hz for the thump */
+        phase = (phase + 6) & 0xff;
+        int thump = (phase < 128) ? phase - 64 : 191 - phase;
+
+        int noise = (signed char) random_next(random);
+        data[i] = ((thump + (noise >> 1)) * envelope) >> 7;
+    }
+}
+
+/* a rumble of smoothed noise fading out */
+static void make_crash(signed char* data, struct Random* random) {
+    int smooth = 0;
+    for (int i = 0; i < CRASH_LENGTH; i++) {
+        int envelope = ((CRASH_LENGTH - i) * 127) >> 13;
+        int noise = (signed char) random_next(random);
+        smooth = (smooth * 3 + noise) >> 2;
+        int sample = (smooth * 2 * envelope) >> 7;
+        data[i] = (sample > 127) ? 127 : (sample < -128) ? -128 : sample;
+    }
+}
+
+/* a square wave sweeping up in pitch, fading out */
+static void make_pickup(signed char* data) {
+    int counter = 0;
+    int level = 96;
+    for (int i = 0; i < PICKUP_LENGTH; i++) {
+        int half_period = 32 - (i >> 7);
+        if (++counter >= half_period) {
+            counter = 0;
+            level = -level;
+        }
+        int envelope = (PICKUP_LENGTH - i) >> 4;
+        data[i] = (level * envelope) >> 7;
+    }
+}
+
+/* make the samples, into a buffer in EWRAM */
+void sounds_init(signed char* buffer) {
+    struct Random random;
+    random_seed(&random, 0x50554e44);
+
+    rotor_sound.data = buffer;
+    rotor_sound.length = ROTOR_LENGTH;
+    rotor_sound.loop = 1;
+    make_rotor(buffer, &random);
+    buffer[ROTOR_LENGTH] = buffer[0];
+    buffer += ROTOR_LENGTH + 1;
+
+    crash_sound.data = buffer;
+    crash_sound.length = CRASH_LENGTH;
+    crash_sound.loop = 0;
+    make_crash(buffer, &random);
+    buffer[CRASH_LENGTH] = 0;
+    buffer += CRASH_LENGTH + 1;
+
+    pickup_sound.data = buffer;
+    pickup_sound.length = PICKUP_LENGTH;
+    pickup_sound.loop = 0;
+    make_pickup(buffer);
+    buffer[PICKUP_LENGTH] = 0;
+}
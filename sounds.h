@@ -0,0 +1,27 @@
+/*
+ * sounds.h
+ * the game's sound effects, which are made up at start up instead of
+ * taking space in ROM
+ */
+
+#ifndef SOUNDS_H
+#define SOUNDS_H
+
+#include "mixer.h"
+
+/* the rotor loops for as long as the copter flies */
+extern struct Sound rotor_sound;
+
+/* the copter hitting something */
+extern struct Sound crash_sound;
+
+/* a short rising blip for reaching a milestone */
+extern struct Sound pickup_sound;
+
+/* make the samples, into a buffer in EWRAM */
+void sounds_init(signed char* buffer);
+
+/* the number of bytes of buffer sounds_init needs */
+#define SOUNDS_BUFFER_SIZE (1536 + 8192 + 2048 + 3)
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * theme_song.h
+ * made by tools/mus2gba from music/theme.mus, 64 rows in 180 bytes
+ */
+
+#include "psg.h"
+
+const unsigned char theme_rows[180] = {
+    0x0d, 0x29, 0x16, 0x22, 0x02, 0x22, 0x08, 0x22, 0x03, 0x22, 0x25, 0x08,
+    0x54, 0x06, 0x29, 0x00, 0x0d, 0x25, 0x22, 0x22, 0x02, 0x22, 0x0d, 0x24,
+    0x16, 0x22, 0x02, 0x25, 0x09, 0x22, 0x22, 0x02, 0x29, 0x09, 0x20, 0x54,
+    0x06, 0x22, 0x00, 0x0d, 0x22, 0x22, 0x22, 0x02, 0x25, 0x0d, 0x1e, 0x12,
+    0x22, 0x02, 0x1e, 0x09, 0x22, 0x22, 0x02, 0x22, 0x09, 0x25, 0x54, 0x06,
+    0x25, 0x00, 0x0c, 0x1e, 0x22, 0x03, 0x22, 0x1e, 0x0d, 0x20, 0x12, 0x22,
+    0x02, 0x22, 0x09, 0x1e, 0x22, 0x02, 0x25, 0x09, 0x1d, 0x54, 0x06, 0x1e,
+    0x00, 0x0c, 0x1e, 0x22, 0x02, 0x22, 0x0d, 0x20, 0x0d, 0x22, 0x02, 0x25,
+    0x08, 0x22, 0x03, 0x25, 0x29, 0x08, 0x54, 0x06, 0x20, 0x00, 0x0d, 0x29,
+    0x19, 0x22, 0x02, 0x25, 0x0d, 0x27, 0x0d, 0x22, 0x02, 0x29, 0x09, 0x25,
+    0x22, 0x02, 0x20, 0x09, 0x27, 0x54, 0x06, 0x25, 0x00, 0x0d, 0x29, 0x19,
+    0x22, 0x02, 0x29, 0x0d, 0x27, 0x14, 0x22, 0x02, 0x20, 0x09, 0x24, 0x22,
+    0x02, 0x24, 0x09, 0x20, 0x54, 0x06, 0x27, 0x00, 0x0c, 0x20, 0x22, 0x03,
+    0x24, 0x20, 0x0d, 0x22, 0x14, 0x22, 0x02, 0x24, 0x08, 0x22, 0x02, 0x27,
+    0x09, 0x00, 0x54, 0x06, 0x20, 0x00, 0x0c, 0x20, 0x22, 0x02, 0x24, 0xff
+};
+
+const unsigned char theme_wave[16] = {
+    0x02, 0x46, 0x89, 0x9a, 0xbb, 0xcc, 0xdd, 0xee,
+    0xff, 0xee, 0xdd, 0xcc, 0xbb, 0xa9, 0x98, 0x64
+};
+
+const struct Song theme_song = {
+    theme_rows, 0,
+    7,
+    {0xb480, 0x5140, 0x4000, 0x8100},
+    theme_wave
+};
@@ -0,0 +1,51 @@
+/*
+ * dump.h
+ * what tools/frametime writes for each frame it dumps and tools/gbappu
+ * draws - everything the GBA's picture unit reads, as it was at the end
+ * of the frame apart from OAM, which is kept for each line it changed on,
+ * one after another in the file, little endian like the GBA
+ */
+
+#ifndef DUMP_H
+#define DUMP_H
+
+/* "HDM2" at the start of each frame */
+#define DUMP_MAGIC 0x324d4448
+
+/* where each part is read from on the GBA, and its size */
+#define DUMP_IO_ADDRESS 0x4000000
+#define DUMP_IO_SIZE 0x60
+#define DUMP_PALETTE_ADDRESS 0x5000000
+#define DUMP_PALETTE_SIZE 0x400
+#define DUMP_VRAM_ADDRESS 0x6000000
+#define DUMP_VRAM_SIZE 0x18000
+#define DUMP_OAM_ADDRESS 0x7000000
+#define DUMP_OAM_SIZE 0x400
+
+/* the most times OAM can change during a frame - the sprite multiplexer
+ * (see mux.h) writes it before the first line and three times after */
+#define DUMP_OAM_CHANGES 8
+
+struct Dump {
+    unsigned int magic;
+
+    /* the number of frames emulated before this one was dumped */
+    unsigned int frame;
+
+    /* the display registers, from display control to the blend ones */
+    unsigned short io[DUMP_IO_SIZE / 2];
+
+    /* the background palette then the sprite one */
+    unsigned short palette[DUMP_PALETTE_SIZE / 2];
+
+    unsigned char vram[DUMP_VRAM_SIZE];
+
+    /* OAM as it was at the start of each line it had changed on, the first
+     * from line 0 - lines oam_lines[n] on are drawn from oam[n] until the
+     * next one, and there are oam_count of them */
+    unsigned int oam_count;
+    unsigned char oam_lines[DUMP_OAM_CHANGES];
+    unsigned short oam[DUMP_OAM_CHANGES][DUMP_OAM_SIZE / 2];
+};
+
+#endif
@@ -0,0 +1,322 @@
+/*
+ * frametime.c
+ * runs program.gba in mGBA with no window, pressing buttons from a script,
+ * and fails if any frame takes longer than its budget - this runs on the
+ * computer doing the build, and needs mGBA's library (libmgba):
+ *
+ *     cc -o frametime tools/frametime.c $(pkg-config --cflags --libs libmgba)
+ *     ./frametime program.gba tools/fly.keys
+ *
+ * the game leaves each frame's time in a struct ProfileDebug in EWRAM (see
+ * profile.h), which is read back after every emulated frame
+ *
+ * options go after the script:
+ *     -lines n     the budget in scanlines, 228 is a whole frame (default)
+ *     -skip n      frames not to check at the start, while it loads (1)
+ *     -csv file    write every frame's cycles to a file
+ *     -dump file   write what the screen is drawn from to a file, for
+ *                  tools/gbappu to draw (see dump.h)
+ *     -every n     how many emulated frames apart the dumps are (60)
+ *
+ * the script has a line for each stretch of frames, the number of frames
+ * and the buttons held for them, with # for comments:
+ *     120          wait on the title screen
+ *     2 START      start a run
+ *     30 UP        climb for half a second
+ *
+ * it also prints the most memory the game had in use from its arena and
+ * pools, which the profiler keeps too, and the number of VRAM claims which
+ * ran over another in a game built with VRAM_CHECK (see vram.h)
+ *
+ * it exits with 0 if every frame fit, 1 if any went over or VRAM was written
+ * over, and 2 if the game could not be run or never started its profiler
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <mgba/core/core.h>
+#include <mgba/core/config.h>
+#include "../profile.h"
+#include "dump.h"
+
+/* the size of the GBA's screen */
+#define SCREEN_WIDTH 240
+#define SCREEN_HEIGHT 160
+
+/* the line being drawn */
+#define REG_VCOUNT 0x4000006
+
+/* the buttons, in the order of their bits in the key register */
+static const char* button_names[] = {
+    "A", "B", "SELECT", "START", "RIGHT", "LEFT", "UP", "DOWN", "R", "L"
+};
+#define BUTTON_COUNT 10
+
+/* a stretch of the script */
+struct Step {
+    int frames;
+    int keys;
+};
+
+/* read the script, returns the number of steps or -1 */
+static int read_script(const char* name, struct Step** steps) {
+    FILE* file = fopen(name, "r");
+    if (file == NULL) {
+        perror(name);
+        return -1;
+    }
+
+    int count = 0, capacity = 64, line_number = 0;
+    *steps = malloc(capacity * sizeof(struct Step));
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        char* token = strtok(line, " \t\r\n");
+        if (token == NULL) {
+            continue;
+        }
+
+        struct Step step = {atoi(token), 0};
+        if (step.frames <= 0) {
+            fprintf(stderr, "%s:%d: bad number of frames '%s'\n", name, line_number, token);
+            fclose(file);
+            return -1;
+        }
+        while ((token = strtok(NULL, " \t\r\n")) != NULL) {
+            int button = 0;
+            while (button < BUTTON_COUNT && strcmp(token, button_names[button]) != 0) {
+                button++;
+            }
+            if (button == BUTTON_COUNT) {
+                fprintf(stderr, "%s:%d: unknown button '%s'\n", name, line_number, token);
+                fclose(file);
+                return -1;
+            }
+            step.keys |= 1 << button;
+        }
+
+        if (count == capacity) {
+            capacity *= 2;
+            *steps = realloc(*steps, capacity * sizeof(struct Step));
+        }
+        (*steps)[count++] = step;
+    }
+    fclose(file);
+    return count;
+}
+
+/* keep OAM as it is now for the line starting, unless it is the same as
+ * the last copy kept - past DUMP_OAM_CHANGES the last copy is replaced */
+static void keep_oam(struct mCore* core, struct Dump* dump, int line) {
+    static unsigned short oam[DUMP_OAM_SIZE / 2];
+    static int warned = 0;
+    for (int i = 0; i < DUMP_OAM_SIZE / 2; i++) {
+        oam[i] = core->rawRead16(core, DUMP_OAM_ADDRESS + i * 2, -1);
+    }
+    if (dump->oam_count > 0 && memcmp(oam, dump->oam[dump->oam_count - 1], sizeof(oam)) == 0) {
+        return;
+    }
+    if (dump->oam_count == DUMP_OAM_CHANGES) {
+        if (!warned) {
+            fprintf(stderr, "OAM changed more than %d times in a frame, the last few are merged\n",
+                    DUMP_OAM_CHANGES);
+            warned = 1;
+        }
+        dump->oam_count--;
+    }
+    dump->oam_lines[dump->oam_count] = line;
+    memcpy(dump->oam[dump->oam_count++], oam, sizeof(oam));
+}
+
+/* run a frame an instruction at a time, keeping OAM at the start of every
+ * line it has changed by, since the multiplexer rewrites it while the frame
+ * is drawn (see mux.h) - a frame ends as its last line is drawn, so this
+ * goes through vblank and then each line of the frame it dumps */
+static void run_frame_lines(struct mCore* core, struct Dump* dump) {
+    unsigned int frame = core->frameCounter(core);
+    int line = -1;
+    dump->oam_count = 0;
+    while (core->frameCounter(core) == frame) {
+        int vcount = core->rawRead16(core, REG_VCOUNT, -1) & 0xff;
+        if (vcount != line) {
+            line = vcount;
+            if (line < SCREEN_HEIGHT) {
+                keep_oam(core, dump, line);
+            }
+        }
+        core->step(core);
+    }
+}
+
+/* write everything else the screen is drawn from, with the raw reads,
+ * which give what was last written to registers the game cannot read back */
+static void write_dump(struct mCore* core, struct Dump* dump, FILE* file, unsigned int frame) {
+    dump->magic = DUMP_MAGIC;
+    dump->frame = frame;
+    for (int i = 0; i < DUMP_IO_SIZE / 2; i++) {
+        dump->io[i] = core->rawRead16(core, DUMP_IO_ADDRESS + i * 2, -1);
+    }
+    for (int i = 0; i < DUMP_PALETTE_SIZE / 2; i++) {
+        dump->palette[i] = core->rawRead16(core, DUMP_PALETTE_ADDRESS + i * 2, -1);
+    }
+    for (int i = 0; i < DUMP_VRAM_SIZE; i++) {
+        dump->vram[i] = core->rawRead8(core, DUMP_VRAM_ADDRESS + i, -1);
+    }
+    fwrite(dump, sizeof(*dump), 1, file);
+}
+
+/* read a word of the debug area */
+static unsigned int read_debug(struct mCore* core, size_t offset) {
+    return core->busRead32(core, PROFILE_DEBUG_ADDRESS + offset);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s program.gba script [-lines n] [-skip n] [-csv file] "
+                "[-dump file] [-every n]\n", argv[0]);
+        return 2;
+    }
+
+    unsigned int lines = PROFILE_FRAME_CYCLES / PROFILE_LINE_CYCLES;
+    unsigned int skip = 1;
+    FILE* csv = NULL;
+    FILE* dump = NULL;
+    unsigned int every = 60;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-lines") == 0) {
+            lines = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "-skip") == 0) {
+            skip = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "-csv") == 0) {
+            csv = fopen(argv[i + 1], "w");
+            if (csv == NULL) {
+                perror(argv[i + 1]);
+                return 2;
+            }
+            fprintf(csv, "frame,cycles,lines\n");
+        } else if (strcmp(argv[i], "-dump") == 0) {
+            dump = fopen(argv[i + 1], "wb");
+            if (dump == NULL) {
+                perror(argv[i + 1]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "-every") == 0) {
+            every = atoi(argv[i + 1]);
+            if (every == 0) {
+                every = 1;
+            }
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    unsigned int budget = lines * PROFILE_LINE_CYCLES;
+
+    struct Step* steps;
+    int step_count = read_script(argv[2], &steps);
+    if (step_count < 0) {
+        return 2;
+    }
+
+    /* start the emulator with somewhere to draw, which it needs even though
+     * nothing looks at it - the GBA's screen size and four bytes a pixel,
+     * the most any build of mGBA uses, rather than asking the core, since
+     * the call for that and the pixel type were renamed after mGBA 0.9 */
+    struct mCore* core = mCoreFind(argv[1]);
+    if (core == NULL || !core->init(core)) {
+        fprintf(stderr, "%s: not a ROM mGBA can run\n", argv[1]);
+        return 2;
+    }
+    mCoreInitConfig(core, NULL);
+    unsigned int* video = malloc(SCREEN_WIDTH * SCREEN_HEIGHT * sizeof(unsigned int));
+    core->setVideoBuffer(core, (void*) video, SCREEN_WIDTH);
+    if (!mCoreLoadFile(core, argv[1])) {
+        fprintf(stderr, "%s: could not be loaded\n", argv[1]);
+        return 2;
+    }
+    core->reset(core);
+
+    /* run the script, checking each frame the game records */
+    unsigned int seen = 0, over = 0, worst = 0, worst_frame = 0, total = 0;
+    unsigned int emulated = 0;
+    int started = 0;
+    static struct Dump dumped;
+    for (int s = 0; s < step_count; s++) {
+        core->setKeys(core, steps[s].keys);
+        for (int f = 0; f < steps[s].frames; f++) {
+            if (dump && ++emulated % every == 0) {
+                run_frame_lines(core, &dumped);
+                write_dump(core, &dumped, dump, emulated);
+            } else {
+                core->runFrame(core);
+            }
+            if (read_debug(core, offsetof(struct ProfileDebug, magic)) != PROFILE_DEBUG_MAGIC) {
+                continue;
+            }
+            started = 1;
+
+            /* the game can record more than one frame per emulated one, but
+             * only the last few are kept */
+            unsigned int frames = read_debug(core, offsetof(struct ProfileDebug, frames));
+            if (frames - seen > PROFILE_DEBUG_HISTORY) {
+                fprintf(stderr, "frames %u to %u were missed\n", seen, frames - PROFILE_DEBUG_HISTORY - 1);
+                seen = frames - PROFILE_DEBUG_HISTORY;
+            }
+            for (; seen < frames; seen++) {
+                unsigned int cycles = read_debug(core, offsetof(struct ProfileDebug, history) +
+                        (seen % PROFILE_DEBUG_HISTORY) * sizeof(unsigned int));
+                if (csv) {
+                    fprintf(csv, "%u,%u,%u\n", seen, cycles, cycles / PROFILE_LINE_CYCLES);
+                }
+                if (seen < skip) {
+                    continue;
+                }
+                total++;
+                if (cycles > worst) {
+                    worst = cycles;
+                    worst_frame = seen;
+                }
+                if (cycles > budget) {
+                    over++;
+                    fprintf(stderr, "frame %u took %u cycles (%u lines), over the budget of %u lines\n",
+                            seen, cycles, cycles / PROFILE_LINE_CYCLES, lines);
+                }
+            }
+        }
+    }
+
+    /* the most memory the game had taken, as of the last frame */
+    unsigned int arena_peak = read_debug(core, offsetof(struct ProfileDebug, peak) + PROFILE_ARENA * sizeof(unsigned int));
+    unsigned int pools_peak = read_debug(core, offsetof(struct ProfileDebug, peak) + PROFILE_POOLS * sizeof(unsigned int));
+    unsigned int vram_overlaps = read_debug(core, offsetof(struct ProfileDebug, peak) + PROFILE_VRAM * sizeof(unsigned int));
+
+    mCoreConfigDeinit(&core->config);
+    core->deinit(core);
+    free(video);
+    free(steps);
+    if (csv) {
+        fclose(csv);
+    }
+    if (dump) {
+        fclose(dump);
+    }
+
+    if (!started) {
+        fprintf(stderr, "%s: the profiler never started\n", argv[1]);
+        return 2;
+    }
+    printf("%u frames checked, the slowest was frame %u at %u cycles (%u of %u lines), %u over budget\n",
+           total, worst_frame, worst, worst / PROFILE_LINE_CYCLES, lines, over);
+    printf("at most %u bytes of the EWRAM arena and %u bytes of pools were in use\n", arena_peak, pools_peak);
+    if (vram_overlaps) {
+        fprintf(stderr, "%u VRAM claims ran over another, see tools/gbappu -vram on a dump\n",
+                vram_overlaps);
+    }
+    return over || vram_overlaps ? 1 : 0;
+}
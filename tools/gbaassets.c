@@ -0,0 +1,1008 @@
+/*
+ * gbaassets.c
+ * builds the game's images from the PNGs listed in assets/assets.txt into
+ * raw files in assets/, then packs them all into assets/pak.bin, which
+ * pak_bin.s puts into ROM with .incbin and pak_ids.h numbers - each image
+ * is done on its own thread, and one whose PNG and settings have not
+ * changed since the last build is skipped, and how much of each shared
+ * palette is used is printed
+ *
+ * this runs on the computer doing the build, and needs libpng:
+ *
+ *     cc -O2 -o gbaassets tools/gbaassets.c -lpng -lpthread
+ *     ./gbaassets
+ *
+ * each line of assets/assets.txt is an image's name, its PNG and then any
+ * of these settings:
+ *     colors n    reduce the image to at most n colors, counting the
+ *                 transparent one, by median cut (256 by default)
+ *     dedupe      keep each different tile once, flipped ones included,
+ *                 and write a screen map of them to name_map.bin
+ *     lz77        compress the tiles in the BIOS's LZ77 format, which
+ *                 LZ77UnCompVram unpacks straight into VRAM
+ *     palette p   share one palette with every other image naming p, so
+ *                 they can all be shown with it loaded once - it goes in
+ *                 p_palette.bin, and the colors limit is the smallest any
+ *                 of them ask for
+ *     vram where  the tiles are loaded into bg0 to bg3 (a char block) or
+ *                 obj (the sprite tiles) and the palette into the one
+ *                 that goes with them, otherwise they are left in ROM
+ *
+ * magenta (0x7c1f) and anything less than half opaque is transparent and
+ * takes color 0, and the other colors are numbered in the order they are
+ * first met going through the image tile by tile, the same as png2gba - a
+ * shared palette goes through its images in the order they are listed
+ *
+ * the content hash of each PNG and its settings is kept in
+ * assets/cache.txt, -f rebuilds everything anyway
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <png.h>
+
+/* where the list, the cache and the binary files are */
+#define ASSET_DIRECTORY "assets"
+#define ASSET_LIST ASSET_DIRECTORY "/assets.txt"
+#define ASSET_CACHE ASSET_DIRECTORY "/cache.txt"
+
+/* changing what the tool writes should change this, so the cache misses */
+#define TOOL_VERSION 3
+
+#define MAX_ASSETS 256
+#define TRANSPARENT 0x7c1f
+
+/* the archive the game loads them from, see pak.h for its layout */
+#define PAK_FILE ASSET_DIRECTORY "/pak.bin"
+#define PAK_MAGIC 0x4b415048
+#define PAK_SLOT_BG_PALETTE 6
+#define PAK_SLOT_OBJ_PALETTE 7
+#define PAK_SLOT_ROM 0xff
+#define PAK_ENTRY_SIZE 12
+
+/* one image to build */
+struct Asset {
+    char name[64];
+    char source[256];
+    char settings[256];
+    int colors;
+    int dedupe;
+    int lz77;
+
+    /* the pak slot its tiles are loaded into */
+    int slot;
+
+    /* the palette it uses, from the list of palettes */
+    int palette;
+
+    /* the hash of the PNG and settings now, and from the last build */
+    unsigned long long hash;
+    unsigned long long cached;
+
+    /* the image once it is read, its colors in tile order */
+    int width, height;
+    unsigned short* pixels;
+
+    /* what happened, filled in by the worker */
+    int built;
+    int failed;
+    char message[256];
+};
+
+/* a palette, either one image's own or one shared by every image in the
+ * list naming it with the palette setting */
+struct Palette {
+    char name[64];
+    int shared;
+    int colors;
+    int slot;
+    int used;
+    unsigned short entries[256];
+
+    /* the color each 15 bit color is cut down to, and its palette entry */
+    unsigned short* remap;
+    short* index;
+};
+
+static struct Asset assets[MAX_ASSETS];
+static int asset_count = 0;
+static struct Palette palettes[MAX_ASSETS];
+static int palette_count = 0;
+
+/* the next asset for a worker to take, and what to do with it */
+static int next_asset = 0;
+static int (*next_job)(struct Asset*);
+static pthread_mutex_t next_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* FNV-1a, 64 bits */
+static unsigned long long hash_bytes(unsigned long long hash, const void* data, size_t length) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/* hash a file's contents along with the asset's settings, 0 if unreadable */
+static unsigned long long hash_asset(struct Asset* asset) {
+    FILE* file = fopen(asset->source, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    int version = TOOL_VERSION;
+    hash = hash_bytes(hash, &version, sizeof(version));
+    hash = hash_bytes(hash, asset->name, strlen(asset->name));
+    hash = hash_bytes(hash, asset->settings, strlen(asset->settings));
+    unsigned char buffer[65536];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        hash = hash_bytes(hash, buffer, length);
+    }
+    fclose(file);
+    return hash;
+}
+
+/* write a whole file, returns 0 on failure */
+static int write_file(const char* path, const void* data, size_t length) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+    int ok = fwrite(data, 1, length, file) == length;
+    return (fclose(file) == 0) && ok;
+}
+
+/* whether a file is there */
+static int file_exists(const char* path) {
+    return access(path, F_OK) == 0;
+}
+
+/* the 15 bit GBA color of an RGBA pixel */
+static unsigned short gba_color(const unsigned char* pixel) {
+    if (pixel[3] < 128) {
+        return TRANSPARENT;
+    }
+    return (pixel[0] >> 3) | ((pixel[1] >> 3) << 5) | ((pixel[2] >> 3) << 10);
+}
+
+/* the parts of a color */
+#define RED(c) ((c) & 31)
+#define GREEN(c) (((c) >> 5) & 31)
+#define BLUE(c) (((c) >> 10) & 31)
+
+/* a box of colors for median cut */
+struct Box {
+    int first, count;
+};
+
+/* sort colors on one of their parts, for splitting boxes - a counting sort,
+ * since there are only 32 values and qsort has nowhere thread safe to keep
+ * which part to compare */
+static void sort_by_part(unsigned short* colors, int count, int shift) {
+    int starts[33] = {0};
+    for (int i = 0; i < count; i++) {
+        starts[((colors[i] >> shift) & 31) + 1]++;
+    }
+    for (int i = 1; i <= 32; i++) {
+        starts[i] += starts[i - 1];
+    }
+    unsigned short* sorted = malloc(count * sizeof(unsigned short));
+    for (int i = 0; i < count; i++) {
+        sorted[starts[(colors[i] >> shift) & 31]++] = colors[i];
+    }
+    memcpy(colors, sorted, count * sizeof(unsigned short));
+    free(sorted);
+}
+
+/* map every color used in the image to one of at most limit colors by
+ * median cut, splitting the box with the widest range of any part at its
+ * median until there are enough boxes, then averaging each box weighted by
+ * how many pixels use each color - remap[c] is the color c becomes */
+static void median_cut(const unsigned int* counts, int limit, unsigned short* remap) {
+    unsigned short* colors = malloc(32768 * sizeof(unsigned short));
+    int used = 0;
+    for (int c = 0; c < 32768; c++) {
+        remap[c] = c;
+        if (counts[c] && c != TRANSPARENT) {
+            colors[used++] = c;
+        }
+    }
+    if (used <= limit) {
+        free(colors);
+        return;
+    }
+
+    struct Box boxes[256];
+    int box_count = 1;
+    boxes[0].first = 0;
+    boxes[0].count = used;
+    while (box_count < limit) {
+        /* the box with the widest part */
+        int best = -1, best_range = 0, best_shift = 0;
+        for (int i = 0; i < box_count; i++) {
+            if (boxes[i].count < 2) {
+                continue;
+            }
+            for (int shift = 0; shift <= 10; shift += 5) {
+                int low = 31, high = 0;
+                for (int j = 0; j < boxes[i].count; j++) {
+                    int part = (colors[boxes[i].first + j] >> shift) & 31;
+                    low = part < low ? part : low;
+                    high = part > high ? part : high;
+                }
+                if (high - low > best_range) {
+                    best = i;
+                    best_range = high - low;
+                    best_shift = shift;
+                }
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+
+        /* split it at the median pixel */
+        struct Box* box = &boxes[best];
+        sort_by_part(colors + box->first, box->count, best_shift);
+        unsigned long long total = 0, half = 0;
+        for (int j = 0; j < box->count; j++) {
+            total += counts[colors[box->first + j]];
+        }
+        int split = 1;
+        for (; split < box->count - 1; split++) {
+            half += counts[colors[box->first + split - 1]];
+            if (half * 2 >= total) {
+                break;
+            }
+        }
+        boxes[box_count].first = box->first + split;
+        boxes[box_count].count = box->count - split;
+        box->count = split;
+        box_count++;
+    }
+
+    for (int i = 0; i < box_count; i++) {
+        unsigned long long r = 0, g = 0, b = 0, weight = 0;
+        for (int j = 0; j < boxes[i].count; j++) {
+            unsigned short c = colors[boxes[i].first + j];
+            r += (unsigned long long) RED(c) * counts[c];
+            g += (unsigned long long) GREEN(c) * counts[c];
+            b += (unsigned long long) BLUE(c) * counts[c];
+            weight += counts[c];
+        }
+        unsigned short average = ((r + weight / 2) / weight) |
+                                 (((g + weight / 2) / weight) << 5) |
+                                 (((b + weight / 2) / weight) << 10);
+        if (average == TRANSPARENT) {
+            average ^= 1;
+        }
+        for (int j = 0; j < boxes[i].count; j++) {
+            remap[colors[boxes[i].first + j]] = average;
+        }
+    }
+    free(colors);
+}
+
+/* compress in the BIOS LZ77 format - a header word of 0x10 and the length,
+ * then groups of a flag byte and eight pieces, each a literal byte or a two
+ * byte copy of 3 to 18 bytes from up to 4096 back - copies are never from
+ * just one byte back, since VRAM is written a halfword at a time, and the
+ * result is padded to a whole word */
+static unsigned char* lz77_compress(const unsigned char* data, int length, int* out_length) {
+    unsigned char* out = malloc(4 + length + length / 8 + 8);
+    int size = 0;
+    out[size++] = 0x10;
+    out[size++] = length & 0xff;
+    out[size++] = (length >> 8) & 0xff;
+    out[size++] = (length >> 16) & 0xff;
+
+    /* chains of earlier positions with the same first three bytes */
+    int* head = malloc(4096 * sizeof(int));
+    int* previous = malloc(length * sizeof(int));
+    for (int i = 0; i < 4096; i++) {
+        head[i] = -1;
+    }
+
+    int position = 0;
+    while (position < length) {
+        int flag_at = size++;
+        out[flag_at] = 0;
+        for (int piece = 0; piece < 8 && position < length; piece++) {
+            int best_length = 0, best_distance = 0;
+            if (position + 3 <= length) {
+                int key = (data[position] << 4 ^ data[position + 1] << 2 ^ data[position + 2]) & 4095;
+                for (int at = head[key]; at >= 0 && position - at <= 4096; at = previous[at]) {
+                    if (position - at < 2) {
+                        continue;
+                    }
+                    int match = 0;
+                    while (match < 18 && position + match < length && data[at + match] == data[position + match]) {
+                        match++;
+                    }
+                    if (match > best_length) {
+                        best_length = match;
+                        best_distance = position - at;
+                        if (match == 18) {
+                            break;
+                        }
+                    }
+                }
+            }
+
+            int step = 1;
+            if (best_length >= 3) {
+                out[flag_at] |= 0x80 >> piece;
+                out[size++] = ((best_length - 3) << 4) | ((best_distance - 1) >> 8);
+                out[size++] = (best_distance - 1) & 0xff;
+                step = best_length;
+            } else {
+                out[size++] = data[position];
+            }
+
+            /* add every position passed over to the chains */
+            for (int i = 0; i < step; i++, position++) {
+                if (position + 3 <= length) {
+                    int key = (data[position] << 4 ^ data[position + 1] << 2 ^ data[position + 2]) & 4095;
+                    previous[position] = head[key];
+                    head[key] = position;
+                }
+            }
+        }
+    }
+    while (size & 3) {
+        out[size++] = 0;
+    }
+    free(head);
+    free(previous);
+    *out_length = size;
+    return out;
+}
+
+/* whether tile a, flipped as asked, is the same as tile b */
+static int same_tile(const unsigned char* a, const unsigned char* b, int flip_x, int flip_y) {
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            int ax = flip_x ? 7 - x : x, ay = flip_y ? 7 - y : y;
+            if (a[ay * 8 + ax] != b[y * 8 + x]) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* read one image's PNG, returns 0 and fills in the message if it goes wrong */
+static int load_asset(struct Asset* asset) {
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&image, asset->source)) {
+        snprintf(asset->message, sizeof(asset->message), "%s", image.message);
+        return 0;
+    }
+    image.format = PNG_FORMAT_RGBA;
+    int width = image.width, height = image.height;
+    unsigned char* pixels = malloc(PNG_IMAGE_SIZE(image));
+    if (!png_image_finish_read(&image, NULL, pixels, 0, NULL)) {
+        snprintf(asset->message, sizeof(asset->message), "%s", image.message);
+        free(pixels);
+        return 0;
+    }
+    if ((width & 7) || (height & 7)) {
+        snprintf(asset->message, sizeof(asset->message), "%dx%d is not a whole number of tiles", width, height);
+        free(pixels);
+        return 0;
+    }
+
+    /* the colors of the pixels in tile order */
+    int tiles_wide = width / 8, tile_count = (width / 8) * (height / 8);
+    asset->width = width;
+    asset->height = height;
+    asset->pixels = malloc(width * height * sizeof(unsigned short));
+    for (int t = 0; t < tile_count; t++) {
+        for (int i = 0; i < 64; i++) {
+            int x = (t % tiles_wide) * 8 + (i & 7), y = (t / tiles_wide) * 8 + (i >> 3);
+            asset->pixels[t * 64 + i] = gba_color(pixels + (y * width + x) * 4);
+        }
+    }
+    free(pixels);
+    return 1;
+}
+
+/* the 512 bytes of a palette as they go into ROM */
+static int write_palette(const char* path, const unsigned short* entries) {
+    unsigned char bytes[512];
+    for (int i = 0; i < 256; i++) {
+        bytes[i * 2] = entries[i] & 0xff;
+        bytes[i * 2 + 1] = entries[i] >> 8;
+    }
+    return write_file(path, bytes, sizeof(bytes));
+}
+
+/* number the colors of every image using a palette, cutting them down
+ * first if there are too many - the images are gone through in the order
+ * they are listed, so the first keeps the numbering it would have on its own,
+ * and a shared palette's files are written here, once */
+static int make_palette(struct Palette* palette) {
+    unsigned int* counts = calloc(32768, sizeof(unsigned int));
+    for (int a = 0; a < asset_count; a++) {
+        struct Asset* asset = &assets[a];
+        if (&palettes[asset->palette] == palette) {
+            for (int i = 0; i < asset->width * asset->height; i++) {
+                counts[asset->pixels[i]]++;
+            }
+        }
+    }
+    palette->remap = malloc(32768 * sizeof(unsigned short));
+    median_cut(counts, palette->colors - 1, palette->remap);
+
+    palette->index = malloc(32768 * sizeof(short));
+    for (int c = 0; c < 32768; c++) {
+        palette->index[c] = -1;
+    }
+    memset(palette->entries, 0, sizeof(palette->entries));
+    palette->entries[0] = TRANSPARENT;
+    palette->index[TRANSPARENT] = 0;
+    palette->used = 1;
+    for (int a = 0; a < asset_count; a++) {
+        struct Asset* asset = &assets[a];
+        if (&palettes[asset->palette] != palette) {
+            continue;
+        }
+        for (int i = 0; i < asset->width * asset->height; i++) {
+            unsigned short c = palette->remap[asset->pixels[i]];
+            if (palette->index[c] < 0) {
+                palette->index[c] = palette->used;
+                palette->entries[palette->used++] = c;
+            }
+        }
+    }
+    free(counts);
+    if (!palette->shared) {
+        return 1;
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%.63s_palette.bin", ASSET_DIRECTORY, palette->name);
+    return write_palette(path, palette->entries);
+}
+
+/* turn one image into tiles with its palette, returns 0 and fills in the
+ * message if it goes wrong */
+static int build_asset(struct Asset* asset) {
+    struct Palette* palette = &palettes[asset->palette];
+    int width = asset->width, height = asset->height;
+    int tile_count = (width / 8) * (height / 8);
+    int pixel_count = width * height;
+    unsigned char* data = malloc(pixel_count);
+    for (int i = 0; i < pixel_count; i++) {
+        data[i] = palette->index[palette->remap[asset->pixels[i]]];
+    }
+
+    /* keep only the different tiles, noting flips in the screen map */
+    int data_length = pixel_count;
+    unsigned short* map = NULL;
+    int unique = tile_count;
+    if (asset->dedupe) {
+        map = malloc(tile_count * sizeof(unsigned short));
+        unique = 0;
+        for (int t = 0; t < tile_count; t++) {
+            unsigned short entry = 0xffff;
+            for (int u = 0; u < unique && entry == 0xffff; u++) {
+                for (int flip = 0; flip < 4; flip++) {
+                    if (same_tile(data + u * 64, data + t * 64, flip & 1, flip >> 1)) {
+                        entry = u | (flip << 10);
+                        break;
+                    }
+                }
+            }
+            if (entry == 0xffff) {
+                memmove(data + unique * 64, data + t * 64, 64);
+                entry = unique++;
+            }
+            map[t] = entry;
+        }
+        data_length = unique * 64;
+    }
+
+    unsigned char* output = data;
+    int output_length = data_length;
+    if (asset->lz77) {
+        output = lz77_compress(data, data_length, &output_length);
+    }
+
+    /* write the binary files - an image with a shared palette leaves it to
+     * make_palette, and they all go into the pak afterwards */
+    char path[512];
+    int ok = 1;
+    snprintf(path, sizeof(path), "%s/%.63s_data.bin", ASSET_DIRECTORY, asset->name);
+    ok &= write_file(path, output, output_length);
+    if (!palette->shared) {
+        snprintf(path, sizeof(path), "%s/%.63s_palette.bin", ASSET_DIRECTORY, asset->name);
+        ok &= write_palette(path, palette->entries);
+    }
+    if (map) {
+        snprintf(path, sizeof(path), "%s/%.63s_map.bin", ASSET_DIRECTORY, asset->name);
+        unsigned char* map_bytes = malloc(tile_count * 2);
+        for (int i = 0; i < tile_count; i++) {
+            map_bytes[i * 2] = map[i] & 0xff;
+            map_bytes[i * 2 + 1] = map[i] >> 8;
+        }
+        ok &= write_file(path, map_bytes, tile_count * 2);
+        free(map_bytes);
+    }
+
+    snprintf(asset->message, sizeof(asset->message), "%dx%d, %d colors%s%s, %d of %d tiles, %d bytes",
+             width, height, palette->used, palette->shared ? " in " : "", palette->shared ? palette->name : "",
+             unique, tile_count, output_length);
+    if (output != data) {
+        free(output);
+    }
+    free(data);
+    free(map);
+    if (!ok) {
+        snprintf(asset->message, sizeof(asset->message), "could not write the output");
+    }
+    return ok;
+}
+
+/* a worker takes assets that need building off the list until there are
+ * none left, doing the job to each */
+static void* worker(void* unused) {
+    (void) unused;
+    while (1) {
+        pthread_mutex_lock(&next_lock);
+        int i = next_asset++;
+        pthread_mutex_unlock(&next_lock);
+        if (i >= asset_count) {
+            return NULL;
+        }
+        struct Asset* asset = &assets[i];
+        if (!asset->built || asset->failed) {
+            continue;
+        }
+        asset->failed = !next_job(asset);
+    }
+}
+
+/* do a job to every asset being built, on up to thread_count threads */
+static void run_workers(int (*job)(struct Asset*), int thread_count) {
+    pthread_t threads[64];
+    next_asset = 0;
+    next_job = job;
+    for (int i = 0; i < thread_count; i++) {
+        pthread_create(&threads[i], NULL, worker, NULL);
+    }
+    for (int i = 0; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+/* the palette with a name, added if there is not one yet */
+static int find_palette(const char* name, int shared) {
+    for (int i = 0; i < palette_count; i++) {
+        if (palettes[i].shared == shared && strcmp(palettes[i].name, name) == 0) {
+            return i;
+        }
+    }
+    struct Palette* palette = &palettes[palette_count];
+    memset(palette, 0, sizeof(*palette));
+    snprintf(palette->name, sizeof(palette->name), "%s", name);
+    palette->shared = shared;
+    palette->colors = 256;
+    palette->slot = -1;
+    return palette_count++;
+}
+
+/* read the list of assets, returns 0 on failure */
+static int read_list( ) {
+    FILE* list = fopen(ASSET_LIST, "r");
+    if (list == NULL) {
+        perror(ASSET_LIST);
+        return 0;
+    }
+    char line[512];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), list)) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+        char* name = strtok(line, " \t");
+        if (name == NULL) {
+            continue;
+        }
+        char* source = strtok(NULL, " \t");
+        if (source == NULL || asset_count == MAX_ASSETS) {
+            fprintf(stderr, "%s:%d: needs a name and a PNG\n", ASSET_LIST, line_number);
+            fclose(list);
+            return 0;
+        }
+
+        struct Asset* asset = &assets[asset_count++];
+        memset(asset, 0, sizeof(*asset));
+        snprintf(asset->name, sizeof(asset->name), "%s", name);
+        snprintf(asset->source, sizeof(asset->source), "%s", source);
+        asset->colors = 256;
+        asset->slot = PAK_SLOT_ROM;
+        char* shared = NULL;
+        char* setting;
+        while ((setting = strtok(NULL, " \t")) != NULL) {
+            size_t used = strlen(asset->settings);
+            snprintf(asset->settings + used, sizeof(asset->settings) - used, " %s", setting);
+            if (strcmp(setting, "dedupe") == 0) {
+                asset->dedupe = 1;
+            } else if (strcmp(setting, "lz77") == 0) {
+                asset->lz77 = 1;
+            } else if (strcmp(setting, "colors") == 0) {
+                char* value = strtok(NULL, " \t");
+                asset->colors = value ? atoi(value) : 0;
+                if (asset->colors < 2 || asset->colors > 256) {
+                    fprintf(stderr, "%s:%d: colors must be 2 to 256\n", ASSET_LIST, line_number);
+                    fclose(list);
+                    return 0;
+                }
+                used = strlen(asset->settings);
+                snprintf(asset->settings + used, sizeof(asset->settings) - used, " %d", asset->colors);
+            } else if (strcmp(setting, "vram") == 0) {
+                static const char* places[] = {"bg0", "bg1", "bg2", "bg3", "obj"};
+                char* value = strtok(NULL, " \t");
+                for (int i = 0; value && i < 5; i++) {
+                    if (strcmp(value, places[i]) == 0) {
+                        asset->slot = i;
+                    }
+                }
+                if (asset->slot == PAK_SLOT_ROM) {
+                    fprintf(stderr, "%s:%d: vram must be bg0 to bg3 or obj\n", ASSET_LIST, line_number);
+                    fclose(list);
+                    return 0;
+                }
+                used = strlen(asset->settings);
+                snprintf(asset->settings + used, sizeof(asset->settings) - used, " %s", value);
+            } else if (strcmp(setting, "palette") == 0) {
+                shared = strtok(NULL, " \t");
+                if (shared == NULL) {
+                    fprintf(stderr, "%s:%d: palette needs a name\n", ASSET_LIST, line_number);
+                    fclose(list);
+                    return 0;
+                }
+                used = strlen(asset->settings);
+                snprintf(asset->settings + used, sizeof(asset->settings) - used, " %s", shared);
+            } else {
+                fprintf(stderr, "%s:%d: unknown setting %s\n", ASSET_LIST, line_number, setting);
+                fclose(list);
+                return 0;
+            }
+        }
+
+        /* a shared palette has as many colors as its smallest limit, and
+         * goes with background or sprite tiles but not both */
+        asset->palette = find_palette(shared ? shared : asset->name, shared != NULL);
+        struct Palette* palette = &palettes[asset->palette];
+        if (asset->colors < palette->colors) {
+            palette->colors = asset->colors;
+        }
+        int palette_slot = PAK_SLOT_ROM;
+        if (asset->slot != PAK_SLOT_ROM) {
+            palette_slot = asset->slot < 4 ? PAK_SLOT_BG_PALETTE : PAK_SLOT_OBJ_PALETTE;
+        }
+        if (palette->slot >= 0 && palette->slot != palette_slot) {
+            fprintf(stderr, "%s:%d: palette %s is shared by images going to different places\n",
+                    ASSET_LIST, line_number, palette->name);
+            fclose(list);
+            return 0;
+        }
+        palette->slot = palette_slot;
+    }
+    fclose(list);
+    return 1;
+}
+
+/* whether an asset's outputs are all still there */
+static int outputs_exist(const struct Asset* asset) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%.63s_data.bin", ASSET_DIRECTORY, asset->name);
+    if (!file_exists(path)) {
+        return 0;
+    }
+    snprintf(path, sizeof(path), "%s/%.63s_palette.bin", ASSET_DIRECTORY, palettes[asset->palette].name);
+    if (!file_exists(path)) {
+        return 0;
+    }
+    snprintf(path, sizeof(path), "%s/%.63s_map.bin", ASSET_DIRECTORY, asset->name);
+    return !asset->dedupe || file_exists(path);
+}
+
+/* one entry of the pak, read back from its binary file */
+struct PakEntry {
+    char id[80];
+    char name[80];
+    char path[512];
+    int slot;
+    int lz77;
+    unsigned char* data;
+    long size;
+};
+
+/* read a whole file, NULL on failure */
+static unsigned char* read_file(const char* path, long* size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char* data = malloc(*size > 0 ? *size : 1);
+    if (fread(data, 1, *size, file) != (size_t) *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+/* add an entry to the pak's list, its ID is the name and part in capitals */
+static void pak_add(struct PakEntry* entries, int* count, const char* name, const char* part, int slot, int lz77) {
+    struct PakEntry* entry = &entries[(*count)++];
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->id, sizeof(entry->id), "PAK_%.63s_%s", name, part);
+    for (char* c = entry->id; *c; c++) {
+        *c = (*c >= 'a' && *c <= 'z') ? *c - 'a' + 'A' : ((*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') ? *c : '_');
+    }
+    snprintf(entry->name, sizeof(entry->name), "%.63s %s", name, part);
+    snprintf(entry->path, sizeof(entry->path), "%s/%.63s_%s.bin", ASSET_DIRECTORY, name, part);
+    entry->slot = slot;
+    entry->lz77 = lz77;
+}
+
+/* put every image's files into the pak, with a stub putting it into ROM and
+ * a header of IDs - the IDs go in list order, each image's tiles then its
+ * palette, which a shared one has after its first image, then its map */
+static int write_pak( ) {
+    struct PakEntry* entries = calloc(MAX_ASSETS * 3, sizeof(struct PakEntry));
+    int count = 0;
+    int* palette_added = calloc(MAX_ASSETS, sizeof(int));
+    for (int i = 0; i < asset_count; i++) {
+        struct Asset* asset = &assets[i];
+        struct Palette* palette = &palettes[asset->palette];
+        pak_add(entries, &count, asset->name, "data", asset->slot, asset->lz77);
+        if (!palette_added[asset->palette]) {
+            pak_add(entries, &count, palette->name, "palette", palette->slot, 0);
+            palette_added[asset->palette] = 1;
+        }
+        if (asset->dedupe) {
+            pak_add(entries, &count, asset->name, "map", PAK_SLOT_ROM, 0);
+        }
+    }
+    free(palette_added);
+
+    /* the header and directory, then each entry word aligned */
+    int ok = 1;
+    long offset = 8 + count * PAK_ENTRY_SIZE;
+    unsigned char* directory = calloc(offset, 1);
+    unsigned int words[2] = {PAK_MAGIC, count};
+    for (int i = 0; i < 8; i++) {
+        directory[i] = words[i / 4] >> ((i & 3) * 8);
+    }
+    for (int i = 0; i < count && ok; i++) {
+        struct PakEntry* entry = &entries[i];
+        entry->data = read_file(entry->path, &entry->size);
+        ok &= entry->data != NULL;
+        unsigned char* at = directory + 8 + i * PAK_ENTRY_SIZE;
+        unsigned int fields[2] = {offset, entry->size};
+        for (int j = 0; j < 8; j++) {
+            at[j] = fields[j / 4] >> ((j & 3) * 8);
+        }
+        at[8] = i & 0xff;
+        at[9] = i >> 8;
+        at[10] = entry->slot;
+        at[11] = entry->lz77;
+        offset += (entry->size + 3) & ~3;
+    }
+
+    FILE* file = ok ? fopen(PAK_FILE, "wb") : NULL;
+    if (file) {
+        static const unsigned char padding[4] = {0};
+        ok &= fwrite(directory, 1, 8 + count * PAK_ENTRY_SIZE, file) == (size_t) (8 + count * PAK_ENTRY_SIZE);
+        for (int i = 0; i < count; i++) {
+            ok &= fwrite(entries[i].data, 1, entries[i].size, file) == (size_t) entries[i].size;
+            ok &= fwrite(padding, 1, -entries[i].size & 3, file) == (size_t) (-entries[i].size & 3);
+        }
+        ok &= fclose(file) == 0;
+    } else {
+        ok = 0;
+    }
+    free(directory);
+
+    FILE* stub = fopen("pak_bin.s", "w");
+    if (stub) {
+        fprintf(stub, "@ pak_bin.s\n@ made by tools/gbaassets, every image in one archive, see pak.h\n"
+                "    .section .rodata\n\n    .align 2\n    .global pak\npak:\n    .incbin \"%s\"\n", PAK_FILE);
+        ok &= fclose(stub) == 0;
+    } else {
+        ok = 0;
+    }
+
+    static const char* places[] = {"char block 0", "char block 1", "char block 2", "char block 3",
+                                   "the sprite tiles", "char block 5", "the background palette",
+                                   "the sprite palette"};
+    FILE* header = fopen("pak_ids.h", "w");
+    if (header) {
+        fprintf(header, "/* pak_ids.h\n * made by tools/gbaassets, the IDs of the entries in %s, which\n"
+                " * goes into ROM through pak_bin.s */\n\n#ifndef PAK_IDS_H\n#define PAK_IDS_H\n\n", PAK_FILE);
+        for (int i = 0; i < count; i++) {
+            struct PakEntry* entry = &entries[i];
+            char comment[128];
+            snprintf(comment, sizeof(comment), "/* %ld bytes%s, %s%s */", entry->size, entry->lz77 ? " of LZ77" : "",
+                     entry->slot == PAK_SLOT_ROM ? "left in ROM" : "into ",
+                     entry->slot == PAK_SLOT_ROM ? "" : places[entry->slot]);
+            fprintf(header, "#define %-28s %3d %s\n", entry->id, i, comment);
+        }
+        fprintf(header, "\n/* the number of entries */\n#define PAK_COUNT %d\n", count);
+        fprintf(header, "\n/* their names in ID order, for debug builds to show */\n#define PAK_NAMES");
+        for (int i = 0; i < count; i++) {
+            fprintf(header, " \\\n    \"%s\"%s", entries[i].name, i + 1 < count ? "," : "");
+        }
+        fprintf(header, "\n\n#endif\n");
+        ok &= fclose(header) == 0;
+    } else {
+        ok = 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        free(entries[i].data);
+    }
+    free(entries);
+    printf("%-16s %d entries, %ld bytes\n", "pak", count, offset);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    int force = (argc > 1 && strcmp(argv[1], "-f") == 0);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (!read_list()) {
+        return 1;
+    }
+
+    /* look up what was built last time */
+    FILE* cache = fopen(ASSET_CACHE, "r");
+    if (cache) {
+        char name[64];
+        unsigned long long hash;
+        while (fscanf(cache, "%63s %llx", name, &hash) == 2) {
+            for (int i = 0; i < asset_count; i++) {
+                if (strcmp(assets[i].name, name) == 0 && !force && outputs_exist(&assets[i])) {
+                    assets[i].cached = hash;
+                }
+            }
+        }
+        fclose(cache);
+    }
+    for (int i = 0; i < asset_count; i++) {
+        assets[i].hash = hash_asset(&assets[i]);
+    }
+
+    /* an image with a shared palette is built again whenever any image
+     * sharing it is, since its colors can be numbered differently - so each
+     * one's hash covers all of theirs, and if one is built they all are */
+    for (int p = 0; p < palette_count; p++) {
+        if (!palettes[p].shared) {
+            continue;
+        }
+        unsigned long long hash = 0xcbf29ce484222325ULL;
+        int stale = 0;
+        for (int i = 0; i < asset_count; i++) {
+            if (assets[i].palette == p) {
+                hash = hash_bytes(hash, &assets[i].hash, sizeof(assets[i].hash));
+            }
+        }
+        for (int i = 0; i < asset_count; i++) {
+            if (assets[i].palette == p && assets[i].hash) {
+                assets[i].hash = hash_bytes(assets[i].hash, &hash, sizeof(hash));
+                stale |= (assets[i].hash != assets[i].cached);
+            }
+        }
+        for (int i = 0; i < asset_count && stale; i++) {
+            if (assets[i].palette == p) {
+                assets[i].cached = 0;
+            }
+        }
+    }
+    for (int i = 0; i < asset_count; i++) {
+        assets[i].built = (assets[i].hash == 0 || assets[i].hash != assets[i].cached);
+    }
+
+    /* a thread for each core, but no more than there are assets */
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int thread_count = (cores < 1) ? 1 : (cores > asset_count ? asset_count : cores);
+    if (thread_count > 64) {
+        thread_count = 64;
+    }
+
+    /* read the PNGs, then number the colors of each palette being built -
+     * if one image of a shared palette could not be read, none of the
+     * others can be built either - then make the tiles */
+    run_workers(load_asset, thread_count);
+    for (int p = 0; p < palette_count; p++) {
+        struct Palette* palette = &palettes[p];
+        const char* unread = NULL;
+        int building = 0;
+        for (int i = 0; i < asset_count; i++) {
+            if (assets[i].palette == p && assets[i].built) {
+                building = 1;
+                unread = assets[i].failed ? assets[i].name : unread;
+            }
+        }
+        if (!building) {
+            continue;
+        }
+        int ok = (unread == NULL) && make_palette(palette);
+        for (int i = 0; i < asset_count; i++) {
+            struct Asset* asset = &assets[i];
+            if (asset->palette == p && !asset->failed && !ok) {
+                asset->failed = 1;
+                if (unread) {
+                    snprintf(asset->message, sizeof(asset->message), "%.63s, which shares its palette, failed", unread);
+                } else {
+                    snprintf(asset->message, sizeof(asset->message), "could not write the palette");
+                }
+            }
+        }
+        if (ok && palette->shared) {
+            printf("%-16s %d of %d colors in the palette shared by", palette->name, palette->used, palette->colors);
+            for (int i = 0; i < asset_count; i++) {
+                if (assets[i].palette == p) {
+                    printf(" %s", assets[i].name);
+                }
+            }
+            printf("\n");
+        }
+    }
+    run_workers(build_asset, thread_count);
+
+    /* report, and write the cache with whatever built */
+    int built = 0, failed = 0;
+    cache = fopen(ASSET_CACHE, "w");
+    for (int i = 0; i < asset_count; i++) {
+        struct Asset* asset = &assets[i];
+        if (asset->built) {
+            printf("%-16s %s%s\n", asset->name, asset->failed ? "failed: " : "", asset->message);
+            built++;
+            failed += asset->failed;
+        }
+        if (cache && !asset->failed && asset->hash) {
+            fprintf(cache, "%s %016llx\n", asset->name, asset->hash);
+        }
+        free(asset->pixels);
+    }
+    if (cache) {
+        fclose(cache);
+    }
+    for (int p = 0; p < palette_count; p++) {
+        free(palettes[p].remap);
+        free(palettes[p].index);
+    }
+
+    /* the pak is put together again from every image's files, built or not */
+    if (!failed && !write_pak()) {
+        printf("could not write the pak\n");
+        failed = 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+    printf("%d of %d assets built, %d up to date, on %d threads in %ld ms\n",
+           built - failed, asset_count, asset_count - built, thread_count, ms);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,748 @@
+/*
+ * gbappu.c
+ * draws the frames tools/frametime dumps the way the GBA's picture unit
+ * would, from the display registers, palettes, VRAM and each line's OAM,
+ * and writes them as PNGs or checks them against golden ones - this runs
+ * on the computer doing the build, and needs libpng:
+ *
+ *     cc -O2 -march=native -DHOST_BUILD -o gbappu tools/gbappu.c vram.c -lpng
+ *     ./frametime program.gba tools/fly.keys -dump fly.dump
+ *     ./gbappu fly.dump -png shots
+ *     ./gbappu fly.dump -golden golden
+ *
+ * options go after the dump:
+ *     -png dir      write each frame to dir/frame_n.png, n being the number
+ *                   of frames emulated before it
+ *     -golden dir   check each frame against dir/frame_n.png, failing if
+ *                   any pixel is different or there is no golden image
+ *     -repeat n     draw every frame n times, to time the drawing (1)
+ *     -vram         print what each frame has in VRAM with vram_report,
+ *                   claimed the way the game claims it (see vram.h)
+ *
+ * it draws mode 0's four tiled backgrounds in 16 or 256 colors at any of
+ * their sizes, scrolled and with flipped tiles, sprites which are not
+ * affine in 1D or 2D mapping, and the blend effects, see through sprites
+ * included - windows, mosaic, affine sprites and the other modes are not
+ * drawn, which is warned about once
+ *
+ * built with AVX2 (-mavx2 or -march=native) the layers are merged and
+ * blended sixteen pixels at a time and the palette lookups gathered eight
+ * at a time
+ *
+ * it exits with 0 if every frame matched or was written, 1 if any did not
+ * match or had claims in VRAM running over each other, and 2 if the dump or an image could not be read or written
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <png.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "dump.h"
+#include "../vram.h"
+
+#define SCREEN_WIDTH 240
+#define SCREEN_HEIGHT 160
+
+/* the registers, as halfwords into the dump's io - the scroll registers
+ * go across then down for each background */
+#define REG_DISPLAY_CONTROL 0x00
+#define REG_BG_CONTROL 0x04
+#define REG_BG_SCROLL 0x08
+#define REG_BLEND_CONTROL 0x28
+#define REG_BLEND_ALPHA 0x29
+#define REG_BLEND_FADE 0x2a
+
+/* the layers, numbered as their bits in the blend control register */
+#define LAYER_OBJ 4
+#define LAYER_BACKDROP 5
+
+/* the things it does not draw, each warned about once */
+#define WARN_MODE 1
+#define WARN_WINDOW 2
+#define WARN_MOSAIC 4
+#define WARN_AFFINE 8
+
+/* the size of a sprite in pixels, by its shape bits then its size bits */
+static const unsigned char obj_widths[3][4] = {{8, 16, 32, 64}, {16, 32, 32, 64}, {8, 8, 16, 32}};
+static const unsigned char obj_heights[3][4] = {{8, 16, 32, 64}, {8, 8, 16, 32}, {16, 32, 32, 64}};
+
+/* the blend registers, with the weights cut down to 16 */
+struct Blend {
+    int effect;
+    int first, second;
+    int weight_a, weight_b;
+    int fade;
+};
+
+/* one line as it is put together - palette indices for each background and
+ * the sprites, 0 where nothing is drawn, then the two layers on top */
+struct Line {
+    unsigned short bg[4][SCREEN_WIDTH];
+    unsigned short obj[SCREEN_WIDTH];
+    unsigned char obj_priority[SCREEN_WIDTH];
+    unsigned char obj_blend[SCREEN_WIDTH];
+
+    unsigned short top[SCREEN_WIDTH];
+    unsigned short below[SCREEN_WIDTH];
+    unsigned short top_layer[SCREEN_WIDTH];
+    unsigned short below_layer[SCREEN_WIDTH];
+
+    unsigned short top_color[SCREEN_WIDTH];
+    unsigned short below_color[SCREEN_WIDTH];
+};
+
+static unsigned int warned = 0;
+
+static void warn(unsigned int what, const char* message) {
+    if (!(warned & what)) {
+        fprintf(stderr, "warning: %s are not drawn\n", message);
+        warned |= what;
+    }
+}
+
+/* a halfword of VRAM, which is little endian like the GBA */
+static unsigned short vram16(const struct Dump* dump, unsigned int address) {
+    return dump->vram[address] | (dump->vram[address + 1] << 8);
+}
+
+/* one line of a tiled background, a tile's worth of pixels at a time */
+static void draw_background(const struct Dump* dump, int bg, int line, unsigned short* out) {
+    unsigned short control = dump->io[REG_BG_CONTROL + bg];
+    int x_scroll = dump->io[REG_BG_SCROLL + bg * 2] & 0x1ff;
+    int y_scroll = dump->io[REG_BG_SCROLL + bg * 2 + 1] & 0x1ff;
+    int width = (control & 0x4000) ? 512 : 256;
+    int height = (control & 0x8000) ? 512 : 256;
+    unsigned int tiles = ((control >> 2) & 3) * 0x4000;
+    unsigned int map = ((control >> 8) & 0x1f) * 0x800;
+    int colors256 = control & 0x80;
+    if (control & 0x40) {
+        warn(WARN_MOSAIC, "mosaic backgrounds");
+    }
+
+    int y = (line + y_scroll) & (height - 1);
+    for (int x = 0; x < SCREEN_WIDTH; ) {
+        /* a 512 wide or high map is more than one screen block */
+        int map_x = (x + x_scroll) & (width - 1);
+        int block = (map_x >> 8) + (y >> 8) * (width >> 8);
+        unsigned int address = map + block * 0x800 + (((y >> 3) & 31) * 32 + ((map_x >> 3) & 31)) * 2;
+        unsigned short entry = address < VRAM_OBJ_TILES ? vram16(dump, address) : 0;
+
+        /* the row of the tile this line goes through, if it is not past
+         * the background tiles */
+        int tile_y = (entry & 0x800) ? 7 - (y & 7) : (y & 7);
+        int size = colors256 ? 8 : 4;
+        unsigned int row = tiles + (entry & 0x3ff) * size * 8 + tile_y * size;
+        const unsigned char* pixels = row + size <= VRAM_OBJ_TILES ? dump->vram + row : NULL;
+        unsigned short bank = colors256 ? 0 : (entry >> 12) << 4;
+
+        int count = 8 - (map_x & 7);
+        if (count > SCREEN_WIDTH - x) {
+            count = SCREEN_WIDTH - x;
+        }
+        int first = map_x & 7, flip = (entry & 0x400) ? 7 : 0;
+        if (pixels == NULL) {
+            for (int i = 0; i < count; i++) {
+                out[x + i] = 0;
+            }
+        } else if (colors256) {
+            for (int i = 0; i < count; i++) {
+                out[x + i] = pixels[(first + i) ^ flip];
+            }
+        } else {
+            for (int i = 0; i < count; i++) {
+                int tile_x = (first + i) ^ flip;
+                unsigned short color = (pixels[tile_x / 2] >> ((tile_x & 1) * 4)) & 15;
+                out[x + i] = color ? color | bank : 0;
+            }
+        }
+        x += count;
+    }
+}
+
+/* the OAM a line was drawn from, the last copy kept from it or before */
+static const unsigned short* line_oam(const struct Dump* dump, int line) {
+    unsigned int change = 0;
+    while (change + 1 < dump->oam_count && dump->oam_lines[change + 1] <= line) {
+        change++;
+    }
+    return dump->oam[change];
+}
+
+/* the sprites on one line, last in OAM first so the first one showing at
+ * each pixel is left on top, whatever their priorities */
+static void draw_sprites(const struct Dump* dump, int line, struct Line* out) {
+    int mapping_1d = dump->io[REG_DISPLAY_CONTROL] & 0x40;
+    const unsigned short* oam = line_oam(dump, line);
+    for (int i = 127; i >= 0; i--) {
+        unsigned short attribute0 = oam[i * 4];
+        unsigned short attribute1 = oam[i * 4 + 1];
+        unsigned short attribute2 = oam[i * 4 + 2];
+        if ((attribute0 & 0x0300) == 0x0200) {
+            continue;
+        }
+        if (attribute0 & 0x0100) {
+            warn(WARN_AFFINE, "affine sprites");
+            continue;
+        }
+        int shape = attribute0 >> 14, mode = (attribute0 >> 10) & 3;
+        if (shape == 3 || mode == 3) {
+            continue;
+        }
+        if (mode == 2) {
+            warn(WARN_WINDOW, "sprite windows");
+            continue;
+        }
+        if (attribute0 & 0x1000) {
+            warn(WARN_MOSAIC, "mosaic sprites");
+        }
+
+        /* y wraps at 256, so the ones near the bottom come in at the top */
+        int width = obj_widths[shape][attribute1 >> 14];
+        int height = obj_heights[shape][attribute1 >> 14];
+        int row = (line - (attribute0 & 0xff)) & 0xff;
+        if (row >= height) {
+            continue;
+        }
+
+        int colors256 = attribute0 & 0x2000;
+        int tile_y = (attribute1 & 0x2000) ? height - 1 - row : row;
+        int step = colors256 ? 2 : 1;
+        int base = attribute2 & 0x3ff;
+        int row_tiles = mapping_1d ? (width / 8) * step : 32;
+        for (int col = 0; col < width; col++) {
+            int x = ((attribute1 & 0x1ff) + col) & 0x1ff;
+            if (x >= SCREEN_WIDTH) {
+                continue;
+            }
+            int tile_x = (attribute1 & 0x1000) ? width - 1 - col : col;
+            int tile = (base + (tile_y >> 3) * row_tiles + (tile_x >> 3) * step) & 0x3ff;
+            unsigned int address = VRAM_OBJ_TILES + tile * 32;
+            unsigned short color;
+            if (colors256) {
+                color = dump->vram[address + (tile_y & 7) * 8 + (tile_x & 7)];
+            } else {
+                color = (dump->vram[address + (tile_y & 7) * 4 + (tile_x & 7) / 2] >> ((tile_x & 1) * 4)) & 15;
+                if (color) {
+                    color |= (attribute2 >> 12) << 4;
+                }
+            }
+            if (color) {
+                out->obj[x] = 256 + color;
+                out->obj_priority[x] = (attribute2 >> 10) & 3;
+                out->obj_blend[x] = (mode == 1);
+            }
+        }
+    }
+}
+
+/* look up the colors of a line of palette indices - with AVX2, eight at a
+ * time, each gathered as a word from a halfword and cut back down, which is
+ * why the palette has a spare entry past the end */
+static void gather(const unsigned short* palette, const unsigned short* indices, unsigned short* colors) {
+#ifdef __AVX2__
+    const __m256i low = _mm256_set1_epi32(0xffff);
+    for (int x = 0; x < SCREEN_WIDTH; x += 8) {
+        __m256i index = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (indices + x)));
+        __m256i color = _mm256_and_si256(_mm256_i32gather_epi32((const int*) palette, index, 2), low);
+        __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(color), _mm256_extracti128_si256(color, 1));
+        _mm_storeu_si128((__m128i*) (colors + x), packed);
+    }
+#else
+    for (int x = 0; x < SCREEN_WIDTH; x++) {
+        colors[x] = palette[indices[x]];
+    }
+#endif
+}
+
+/* lay one layer over what is already on the line - where it shows, what
+ * was on top goes below it - sprites only show at their own priority */
+static void merge(struct Line* line, const unsigned short* colors, int layer, int priority) {
+#ifdef __AVX2__
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(-1);
+    const __m256i layer16 = _mm256_set1_epi16(layer);
+    const __m256i priority16 = _mm256_set1_epi16(priority);
+    for (int x = 0; x < SCREEN_WIDTH; x += 16) {
+        __m256i color = _mm256_loadu_si256((const __m256i*) (colors + x));
+        __m256i hidden = _mm256_cmpeq_epi16(color, zero);
+        if (layer == LAYER_OBJ) {
+            __m256i object = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (line->obj_priority + x)));
+            hidden = _mm256_or_si256(hidden, _mm256_xor_si256(_mm256_cmpeq_epi16(object, priority16), ones));
+        }
+        __m256i top = _mm256_loadu_si256((const __m256i*) (line->top + x));
+        __m256i top_layer = _mm256_loadu_si256((const __m256i*) (line->top_layer + x));
+        __m256i below = _mm256_loadu_si256((const __m256i*) (line->below + x));
+        __m256i below_layer = _mm256_loadu_si256((const __m256i*) (line->below_layer + x));
+        _mm256_storeu_si256((__m256i*) (line->below + x), _mm256_blendv_epi8(top, below, hidden));
+        _mm256_storeu_si256((__m256i*) (line->below_layer + x), _mm256_blendv_epi8(top_layer, below_layer, hidden));
+        _mm256_storeu_si256((__m256i*) (line->top + x), _mm256_blendv_epi8(color, top, hidden));
+        _mm256_storeu_si256((__m256i*) (line->top_layer + x), _mm256_blendv_epi8(layer16, top_layer, hidden));
+    }
+#else
+    for (int x = 0; x < SCREEN_WIDTH; x++) {
+        if (colors[x] && (layer != LAYER_OBJ || line->obj_priority[x] == priority)) {
+            line->below[x] = line->top[x];
+            line->below_layer[x] = line->top_layer[x];
+            line->top[x] = colors[x];
+            line->top_layer[x] = layer;
+        }
+    }
+#endif
+}
+
+#ifdef __AVX2__
+/* mix sixteen pairs of colors a channel at a time, each weight out of 16 */
+static __m256i blend16(__m256i a, __m256i b, __m256i weight_a, __m256i weight_b) {
+    const __m256i mask = _mm256_set1_epi16(31);
+    __m256i result = _mm256_setzero_si256();
+    for (int shift = 0; shift < 15; shift += 5) {
+        __m128i count = _mm_cvtsi32_si128(shift);
+        __m256i channel_a = _mm256_and_si256(_mm256_srl_epi16(a, count), mask);
+        __m256i channel_b = _mm256_and_si256(_mm256_srl_epi16(b, count), mask);
+        __m256i channel = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(channel_a, weight_a),
+                                                             _mm256_mullo_epi16(channel_b, weight_b)), 4);
+        result = _mm256_or_si256(result, _mm256_sll_epi16(_mm256_min_epu16(channel, mask), count));
+    }
+    return result;
+}
+
+/* which of sixteen layer numbers are in a set of blend target bits */
+static __m256i layers_in(__m256i layers, int set) {
+    __m256i in = _mm256_setzero_si256();
+    for (int layer = 0; layer <= LAYER_BACKDROP; layer++) {
+        if (set & (1 << layer)) {
+            in = _mm256_or_si256(in, _mm256_cmpeq_epi16(layers, _mm256_set1_epi16(layer)));
+        }
+    }
+    return in;
+}
+#else
+/* mix two colors a channel at a time, each weight out of 16 */
+static unsigned short blend(unsigned short a, unsigned short b, int weight_a, int weight_b) {
+    unsigned short result = 0;
+    for (int shift = 0; shift < 15; shift += 5) {
+        int channel = (((a >> shift) & 31) * weight_a + ((b >> shift) & 31) * weight_b) >> 4;
+        result |= (channel > 31 ? 31 : channel) << shift;
+    }
+    return result;
+}
+#endif
+
+/* work out the colors of a line from its two front layers - see through
+ * sprites blend with what is under them whatever the effect, otherwise the
+ * effect applies to the first target */
+static void apply_blend(const struct Line* line, const struct Blend* blend_registers, unsigned short* out) {
+    int effect = blend_registers->effect;
+    int first = blend_registers->first, second = blend_registers->second;
+    int weight_a = blend_registers->weight_a, weight_b = blend_registers->weight_b;
+    int fade = blend_registers->fade;
+#ifdef __AVX2__
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alpha_a = _mm256_set1_epi16(weight_a), alpha_b = _mm256_set1_epi16(weight_b);
+    const __m256i fade_a = _mm256_set1_epi16(16 - fade), fade_b = _mm256_set1_epi16(fade);
+    const __m256i white = _mm256_set1_epi16(0x7fff);
+    const __m256i object = _mm256_set1_epi16(LAYER_OBJ);
+    for (int x = 0; x < SCREEN_WIDTH; x += 16) {
+        __m256i top = _mm256_loadu_si256((const __m256i*) (line->top_color + x));
+        __m256i below = _mm256_loadu_si256((const __m256i*) (line->below_color + x));
+        __m256i top_layer = _mm256_loadu_si256((const __m256i*) (line->top_layer + x));
+        __m256i below_layer = _mm256_loadu_si256((const __m256i*) (line->below_layer + x));
+        __m256i see_through = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (line->obj_blend + x)));
+
+        __m256i second_below = layers_in(below_layer, second);
+        see_through = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi16(top_layer, object),
+                                                        _mm256_cmpgt_epi16(see_through, zero)), second_below);
+        __m256i first_top = _mm256_andnot_si256(see_through, layers_in(top_layer, first));
+
+        __m256i alpha = see_through;
+        if (effect == 1) {
+            alpha = _mm256_or_si256(alpha, _mm256_and_si256(first_top, second_below));
+        }
+        __m256i color = top;
+        if (!_mm256_testz_si256(alpha, alpha)) {
+            color = _mm256_blendv_epi8(color, blend16(top, below, alpha_a, alpha_b), alpha);
+        }
+        if (effect == 2) {
+            color = _mm256_blendv_epi8(color, blend16(top, white, fade_a, fade_b), first_top);
+        } else if (effect == 3) {
+            color = _mm256_blendv_epi8(color, blend16(top, zero, fade_a, zero), first_top);
+        }
+        _mm256_storeu_si256((__m256i*) (out + x), color);
+    }
+#else
+    for (int x = 0; x < SCREEN_WIDTH; x++) {
+        unsigned short color = line->top_color[x];
+        int top = line->top_layer[x], below = line->below_layer[x];
+        if (top == LAYER_OBJ && line->obj_blend[x] && (second & (1 << below))) {
+            color = blend(color, line->below_color[x], weight_a, weight_b);
+        } else if (first & (1 << top)) {
+            if (effect == 1 && (second & (1 << below))) {
+                color = blend(color, line->below_color[x], weight_a, weight_b);
+            } else if (effect == 2) {
+                color = blend(color, 0x7fff, 16 - fade, fade);
+            } else if (effect == 3) {
+                color = blend(color, 0, 16 - fade, 0);
+            }
+        }
+        out[x] = color;
+    }
+#endif
+}
+
+/* draw a whole frame as 15 bit colors */
+static void draw_frame(const struct Dump* dump, unsigned short* frame) {
+    static struct Line line;
+    unsigned short display = dump->io[REG_DISPLAY_CONTROL];
+
+    /* a forced blank shows white */
+    if (display & 0x80) {
+        for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
+            frame[i] = 0x7fff;
+        }
+        return;
+    }
+    if (display & 0xe000) {
+        warn(WARN_WINDOW, "windows");
+    }
+
+    /* the backgrounds only in mode 0, the sprites in any */
+    int backgrounds = (display >> 8) & 15;
+    if ((display & 7) != 0) {
+        warn(WARN_MODE, "modes other than 0");
+        backgrounds = 0;
+    }
+    int sprites = display & 0x1000;
+
+    /* the order the layers are stacked in, front first - at the same
+     * priority sprites go in front, then the lowest background */
+    unsigned char layers[20];
+    unsigned char layer_priority[20];
+    int layer_count = 0;
+    for (int priority = 0; priority < 4; priority++) {
+        if (sprites) {
+            layer_priority[layer_count] = priority;
+            layers[layer_count++] = LAYER_OBJ;
+        }
+        for (int bg = 0; bg < 4; bg++) {
+            if ((backgrounds & (1 << bg)) && (dump->io[REG_BG_CONTROL + bg] & 3) == priority) {
+                layer_priority[layer_count] = priority;
+                layers[layer_count++] = bg;
+            }
+        }
+    }
+
+    /* the palette with a spare entry, see gather */
+    unsigned short palette[DUMP_PALETTE_SIZE / 2 + 2];
+    for (int i = 0; i < DUMP_PALETTE_SIZE / 2; i++) {
+        palette[i] = dump->palette[i] & 0x7fff;
+    }
+    palette[DUMP_PALETTE_SIZE / 2] = palette[DUMP_PALETTE_SIZE / 2 + 1] = 0;
+
+    unsigned short blend_control = dump->io[REG_BLEND_CONTROL];
+    struct Blend blend_registers;
+    blend_registers.effect = (blend_control >> 6) & 3;
+    blend_registers.first = blend_control & 0x3f;
+    blend_registers.second = (blend_control >> 8) & 0x3f;
+    blend_registers.weight_a = dump->io[REG_BLEND_ALPHA] & 31;
+    blend_registers.weight_b = (dump->io[REG_BLEND_ALPHA] >> 8) & 31;
+    blend_registers.fade = dump->io[REG_BLEND_FADE] & 31;
+    blend_registers.weight_a = blend_registers.weight_a > 16 ? 16 : blend_registers.weight_a;
+    blend_registers.weight_b = blend_registers.weight_b > 16 ? 16 : blend_registers.weight_b;
+    blend_registers.fade = blend_registers.fade > 16 ? 16 : blend_registers.fade;
+
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        for (int bg = 0; bg < 4; bg++) {
+            if (backgrounds & (1 << bg)) {
+                draw_background(dump, bg, y, line.bg[bg]);
+            }
+        }
+        memset(line.obj, 0, sizeof(line.obj));
+        if (sprites) {
+            draw_sprites(dump, y, &line);
+        }
+
+        /* find the two front layers showing at each pixel by laying each
+         * one over the last from the back, starting with the backdrop */
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            line.top[x] = line.below[x] = 0;
+            line.top_layer[x] = line.below_layer[x] = LAYER_BACKDROP;
+        }
+        for (int i = layer_count - 1; i >= 0; i--) {
+            int layer = layers[i];
+            merge(&line, (layer == LAYER_OBJ) ? line.obj : line.bg[layer], layer, layer_priority[i]);
+        }
+
+        gather(palette, line.top, line.top_color);
+        gather(palette, line.below, line.below_color);
+        apply_blend(&line, &blend_registers, frame + y * SCREEN_WIDTH);
+    }
+}
+
+/* a 5 bit channel spread out to 8 bits */
+static unsigned char channel8(unsigned short color, int shift) {
+    int value = (color >> shift) & 31;
+    return (value << 3) | (value >> 2);
+}
+
+static void frame_name(char* name, size_t size, const char* directory, unsigned int frame) {
+    snprintf(name, size, "%s/frame_%u.png", directory, frame);
+}
+
+/* write a frame out as an RGB PNG, returns 0 if it could not be */
+static int write_png(const char* name, const unsigned short* frame) {
+    static unsigned char pixels[SCREEN_WIDTH * SCREEN_HEIGHT * 3];
+    for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
+        pixels[i * 3] = channel8(frame[i], 0);
+        pixels[i * 3 + 1] = channel8(frame[i], 5);
+        pixels[i * 3 + 2] = channel8(frame[i], 10);
+    }
+
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    image.width = SCREEN_WIDTH;
+    image.height = SCREEN_HEIGHT;
+    image.format = PNG_FORMAT_RGB;
+    if (!png_image_write_to_file(&image, name, 0, pixels, 0, NULL)) {
+        fprintf(stderr, "%s: %s\n", name, image.message);
+        return 0;
+    }
+    return 1;
+}
+
+/* check a frame against a golden PNG, cut back to 15 bits, returns the
+ * number of pixels which differ or -1 if it could not be read */
+static int check_png(const char* name, const unsigned short* frame) {
+    static unsigned char pixels[SCREEN_WIDTH * SCREEN_HEIGHT * 3];
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&image, name)) {
+        fprintf(stderr, "%s: %s\n", name, image.message);
+        return -1;
+    }
+    if (image.width != SCREEN_WIDTH || image.height != SCREEN_HEIGHT) {
+        fprintf(stderr, "%s: is %ux%u, not the screen's size\n", name, image.width, image.height);
+        png_image_free(&image);
+        return -1;
+    }
+    image.format = PNG_FORMAT_RGB;
+    if (!png_image_finish_read(&image, NULL, pixels, 0, NULL)) {
+        fprintf(stderr, "%s: %s\n", name, image.message);
+        return -1;
+    }
+
+    int different = 0;
+    for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
+        unsigned short golden = (pixels[i * 3] >> 3) | ((pixels[i * 3 + 1] >> 3) << 5) |
+                                ((pixels[i * 3 + 2] >> 3) << 10);
+        if (golden != frame[i]) {
+            if (different == 0) {
+                fprintf(stderr, "%s: first difference at %d, %d: 0x%04x, not 0x%04x\n",
+                        name, i % SCREEN_WIDTH, i / SCREEN_WIDTH, frame[i], golden);
+            }
+            different++;
+        }
+    }
+    return different;
+}
+
+/* claim what a frame shows the way the game does and print the map - each
+ * background's screen map, the tiles of each char block up to the highest
+ * one a map on it uses unless they are all still 0, and each run of sprite
+ * tiles the sprites showing on any line use - returns the number of claims running over
+ * another or backgrounds on char blocks nothing was put in */
+static int report_vram(const struct Dump* dump) {
+    static const char* map_names[4] = {"bg0 map", "bg1 map", "bg2 map", "bg3 map"};
+    static const char* tile_names[4] = {"bg0 tiles", "bg1 tiles", "bg2 tiles", "bg3 tiles"};
+    static const char* block_names[4] = {"char block 0 tiles", "char block 1 tiles",
+                                         "char block 2 tiles", "char block 3 tiles"};
+    static const unsigned char map_blocks[4] = {1, 2, 2, 4};
+    static char run_names[VRAM_MAX_REGIONS][32];
+
+    unsigned short display = dump->io[REG_DISPLAY_CONTROL];
+    vram_clear();
+    vram_use_objects(display);
+
+    /* the tiled backgrounds, with the tiles of backgrounds sharing a char
+     * block claimed once for all of them */
+    int backgrounds = (display & 7) == 0 ? (display >> 8) & 15 : 0;
+    unsigned int tiles_end[4] = {0, 0, 0, 0};
+    for (int bg = 0; bg < 4; bg++) {
+        if (!(backgrounds & (1 << bg))) {
+            continue;
+        }
+        unsigned short control = dump->io[REG_BG_CONTROL + bg];
+        vram_claim_map(control, map_names[bg]);
+
+        unsigned int map = ((control >> 8) & 0x1f) * VRAM_SCREEN_BLOCK_SIZE;
+        unsigned int map_end = map + map_blocks[control >> 14] * VRAM_SCREEN_BLOCK_SIZE;
+        unsigned int highest = 0;
+        for (unsigned int address = map; address < map_end && address < VRAM_OBJ_TILES; address += 2) {
+            unsigned int tile = vram16(dump, address) & 0x3ff;
+            highest = tile > highest ? tile : highest;
+        }
+        int block = (control >> 2) & 3;
+        unsigned int end = block * VRAM_CHAR_BLOCK_SIZE + (highest + 1) * ((control & 0x80) ? 64 : 32);
+        tiles_end[block] = end > tiles_end[block] ? end : tiles_end[block];
+    }
+    for (int block = 0; block < 4; block++) {
+        unsigned int start = block * VRAM_CHAR_BLOCK_SIZE;
+        unsigned int end = tiles_end[block] < VRAM_OBJ_TILES ? tiles_end[block] : VRAM_OBJ_TILES;
+        unsigned int address = start;
+        while (address < end && dump->vram[address] == 0) {
+            address++;
+        }
+        if (address < end) {
+            vram_claim(start, tiles_end[block] - start, block_names[block]);
+        }
+    }
+    for (int bg = 0; bg < 4; bg++) {
+        if (backgrounds & (1 << bg)) {
+            vram_check_tiles(dump->io[REG_BG_CONTROL + bg], tile_names[bg]);
+        }
+    }
+
+    /* mark every sprite tile a sprite showing uses, then claim them a run
+     * at a time */
+    static unsigned char used[1024];
+    memset(used, 0, sizeof(used));
+    int mapping_1d = display & 0x40;
+    for (int i = 0; (display & 0x1000) && i < 128 * (int) dump->oam_count; i++) {
+        unsigned short attribute0 = dump->oam[i / 128][i % 128 * 4];
+        unsigned short attribute1 = dump->oam[i / 128][i % 128 * 4 + 1];
+        unsigned short attribute2 = dump->oam[i / 128][i % 128 * 4 + 2];
+        int shape = attribute0 >> 14;
+        if ((attribute0 & 0x0300) == 0x0200 || shape == 3) {
+            continue;
+        }
+        int step = (attribute0 & 0x2000) ? 2 : 1;
+        int across = obj_widths[shape][attribute1 >> 14] / 8 * step;
+        int down = obj_heights[shape][attribute1 >> 14] / 8;
+        int row_tiles = mapping_1d ? across : 32;
+        for (int row = 0; row < down; row++) {
+            for (int col = 0; col < across; col++) {
+                used[((attribute2 & 0x3ff) + row * row_tiles + col) & 0x3ff] = 1;
+            }
+        }
+    }
+    int runs = 0;
+    for (int tile = 0; tile < 1024; tile++) {
+        if (!used[tile] || (tile > 0 && used[tile - 1])) {
+            continue;
+        }
+        int end = tile;
+        while (end < 1024 && used[end]) {
+            end++;
+        }
+        if (runs < VRAM_MAX_REGIONS) {
+            snprintf(run_names[runs], sizeof(run_names[runs]), "sprite tiles %d to %d", tile, end - 1);
+            vram_claim(VRAM_OBJ_TILES + tile * 32, (end - tile) * 32, run_names[runs++]);
+        }
+    }
+
+    printf("frame %u: ", dump->frame);
+    vram_report();
+    return vram_check.overlaps;
+}
+
+static double seconds( ) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s frames.dump [-png dir] [-golden dir] [-repeat n] [-vram]\n", argv[0]);
+        return 2;
+    }
+
+    const char* png_directory = NULL;
+    const char* golden_directory = NULL;
+    int repeat = 1, vram = 0;
+    for (int i = 2; i < argc; i += 2) {
+        if (strcmp(argv[i], "-vram") == 0) {
+            vram = 1;
+            i--;
+        } else if (i + 1 == argc) {
+            fprintf(stderr, "%s needs a value\n", argv[i]);
+            return 2;
+        } else if (strcmp(argv[i], "-png") == 0) {
+            png_directory = argv[i + 1];
+        } else if (strcmp(argv[i], "-golden") == 0) {
+            golden_directory = argv[i + 1];
+        } else if (strcmp(argv[i], "-repeat") == 0) {
+            repeat = atoi(argv[i + 1]);
+            repeat = repeat < 1 ? 1 : repeat;
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    FILE* file = fopen(argv[1], "rb");
+    if (file == NULL) {
+        perror(argv[1]);
+        return 2;
+    }
+
+    static struct Dump dump;
+    static unsigned short frame[SCREEN_WIDTH * SCREEN_HEIGHT];
+    int frames = 0, failed = 0, errors = 0, overlapping = 0;
+    double drawing = 0;
+    while (fread(&dump, sizeof(dump), 1, file) == 1) {
+        if (dump.magic != DUMP_MAGIC || dump.oam_count == 0 || dump.oam_count > DUMP_OAM_CHANGES) {
+            fprintf(stderr, "%s: frame %d is not a dump\n", argv[1], frames);
+            errors++;
+            break;
+        }
+
+        double start = seconds();
+        for (int r = 0; r < repeat; r++) {
+            draw_frame(&dump, frame);
+        }
+        drawing += seconds() - start;
+        frames++;
+
+        char name[1024];
+        if (png_directory) {
+            frame_name(name, sizeof(name), png_directory, dump.frame);
+            errors += !write_png(name, frame);
+        }
+        if (golden_directory) {
+            frame_name(name, sizeof(name), golden_directory, dump.frame);
+            int different = check_png(name, frame);
+            if (different < 0) {
+                errors++;
+            } else if (different > 0) {
+                fprintf(stderr, "frame %u has %d pixels different\n", dump.frame, different);
+                failed++;
+            }
+        }
+        if (vram && report_vram(&dump)) {
+            overlapping++;
+        }
+    }
+    fclose(file);
+
+    double drawn = (double) frames * repeat;
+    printf("%d frames drawn %d times each in %.3f seconds, %.0f a second",
+           frames, repeat, drawing, drawing > 0 ? drawn / drawing : 0);
+    if (golden_directory) {
+        printf(", %d did not match", failed);
+    }
+    if (vram) {
+        printf(", %d had VRAM claims overlapping", overlapping);
+    }
+    printf("\n");
+    if (errors) {
+        return 2;
+    }
+    return failed || overlapping ? 1 : 0;
+}
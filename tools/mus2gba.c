@@ -0,0 +1,253 @@
+/*
+ * mus2gba.c
+ * turns a song written as text into a header of pattern data for psg.c,
+ * this runs on the computer doing the build, not the GBA:
+ *
+ *     cc -o mus2gba tools/mus2gba.c
+ *     ./mus2gba music/theme.mus theme_song.h
+ *
+ * the song file sets up the channels and then lists rows, one line each:
+ *
+ *     speed 7                   frames each row lasts
+ *     square1 duty 2 volume 12 fade 3
+ *     square2 duty 1 volume 8 fade 2
+ *     wave volume 2 shape 0123456789abcdeffedcba9876543210
+ *     noise volume 10 fade 1
+ *     loop                      the song goes back here at the end
+ *     C-4 ... A-2 N21           one column per channel
+ *
+ * duty is 0 to 3 (1/8, 1/4, 1/2, 3/4), volume 0 to 15 and fade 0 to 7 (how
+ * quickly the note dies away, 0 holds it) - the wave channel's volume is 1
+ * for full, 2 for half and 3 for a quarter, and its shape is 32 hex digits
+ *
+ * in the rows, a note is its name, - or # and its octave from 2 to 7, ...
+ * leaves the channel alone and === stops it, the noise column takes N and
+ * two hex digits for the noise control register, and # starts a comment
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "../psg.h"
+
+/* the longest song, in bytes of rows */
+#define MAX_ROWS 16384
+
+static const char* input_name;
+static int line_number = 0;
+
+/* stop with a message saying where the problem is */
+static void fail(const char* message, const char* token) {
+    fprintf(stderr, "%s:%d: %s '%s'\n", input_name, line_number, message, token);
+    exit(1);
+}
+
+/* read a number for a setting, which has to be within a range */
+static int number(const char* token, int low, int high) {
+    char* end;
+    long value = strtol(token ? token : "", &end, 10);
+    if (token == NULL || *end != '\0' || value < low || value > high) {
+        fail("bad number", token ? token : "");
+    }
+    return value;
+}
+
+/* the note value for a token in one of the tonal columns */
+static int tonal_note(const char* token) {
+    static const char names[] = "C D EF G A B";
+    const char* name = strchr(names, toupper(token[0]));
+    if (name == NULL || strlen(token) != 3 ||
+        (token[1] != '-' && token[1] != '#') || token[2] < '2' || token[2] > '7') {
+        fail("bad note", token);
+    }
+    int semitone = (name - names) + (token[1] == '#');
+    if (semitone >= 12) {
+        fail("bad note", token);
+    }
+    return (token[2] - '2') * 12 + semitone + 1;
+}
+
+/* the note value for a token in the noise column */
+static int noise_note(const char* token) {
+    char* end;
+    long value = strtol(token + 1, &end, 16);
+    if (toupper(token[0]) != 'N' || strlen(token) != 3 || *end != '\0' || value > 0xfe) {
+        fail("bad noise", token);
+    }
+    return value + 1;
+}
+
+/* the envelope register bits for the square and noise channels, from the
+ * rest of a channel line */
+static int envelope(int square) {
+    int duty = 2, volume = 15, fade = 0;
+    char* key;
+    while ((key = strtok(NULL, " \t\r\n")) != NULL) {
+        char* value = strtok(NULL, " \t\r\n");
+        if (square && strcmp(key, "duty") == 0) {
+            duty = number(value, 0, 3);
+        } else if (strcmp(key, "volume") == 0) {
+            volume = number(value, 0, 15);
+        } else if (strcmp(key, "fade") == 0) {
+            fade = number(value, 0, 7);
+        } else {
+            fail("unknown setting", key);
+        }
+    }
+    return (square ? duty << 6 : 0) | (fade << 8) | (volume << 12);
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s song.mus song.h\n", argv[0]);
+        return 1;
+    }
+    input_name = argv[1];
+    FILE* input = fopen(argv[1], "r");
+    if (input == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    /* the song's name comes from the file name, for the C names */
+    char name[64];
+    const char* base = strrchr(argv[1], '/');
+    base = base ? base + 1 : argv[1];
+    int length = 0;
+    while (base[length] && base[length] != '.' && length < 63) {
+        name[length] = isalnum((unsigned char) base[length]) ? base[length] : '_';
+        length++;
+    }
+    name[length] = '\0';
+
+    static unsigned char rows[MAX_ROWS];
+    int size = 0, count = 0, loop = 0, speed = 6;
+    int envelopes[PSG_CHANNELS] = {0x0280 | 0xf000, 0x0280 | 0xf000, 0x2000, 0xf000};
+    unsigned char shape[16] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+        0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10
+    };
+
+    char line[256];
+    while (fgets(line, sizeof(line), input)) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        /* a # straight after a note name is a sharp, not a comment */
+        while (comment && comment > line && isalpha((unsigned char) comment[-1])) {
+            comment = strchr(comment + 1, '#');
+        }
+        if (comment) {
+            *comment = '\0';
+        }
+
+        char* token = strtok(line, " \t\r\n");
+        if (token == NULL) {
+            continue;
+        }
+
+        if (strcmp(token, "speed") == 0) {
+            speed = number(strtok(NULL, " \t\r\n"), 1, 255);
+        } else if (strcmp(token, "square1") == 0) {
+            envelopes[PSG_SQUARE1] = envelope(1);
+        } else if (strcmp(token, "square2") == 0) {
+            envelopes[PSG_SQUARE2] = envelope(1);
+        } else if (strcmp(token, "noise") == 0) {
+            envelopes[PSG_NOISE] = envelope(0);
+        } else if (strcmp(token, "wave") == 0) {
+            char* key;
+            while ((key = strtok(NULL, " \t\r\n")) != NULL) {
+                char* value = strtok(NULL, " \t\r\n");
+                if (strcmp(key, "volume") == 0) {
+                    envelopes[PSG_WAVE] = number(value, 1, 3) << 13;
+                } else if (strcmp(key, "shape") == 0) {
+                    if (value == NULL || strlen(value) != 32) {
+                        fail("the shape needs 32 digits", value ? value : "");
+                    }
+                    for (int i = 0; i < 16; i++) {
+                        char pair[3] = {value[i * 2], value[i * 2 + 1], '\0'};
+                        char* end;
+                        shape[i] = strtol(pair, &end, 16);
+                        if (*end != '\0') {
+                            fail("bad shape", value);
+                        }
+                    }
+                } else {
+                    fail("unknown setting", key);
+                }
+            }
+        } else if (strcmp(token, "loop") == 0) {
+            loop = size;
+        } else {
+            /* a row, with a column for each channel */
+            unsigned char notes[PSG_CHANNELS];
+            int channels = 0;
+            for (int channel = 0; channel < PSG_CHANNELS; channel++) {
+                if (token == NULL) {
+                    fail("the row needs a column for each channel", "");
+                }
+                if (strcmp(token, "===") == 0) {
+                    channels |= 1 << channel;
+                    notes[channel] = PSG_NOTE_OFF;
+                } else if (strcmp(token, "...") != 0) {
+                    channels |= 1 << channel;
+                    notes[channel] = (channel == PSG_NOISE) ? noise_note(token) : tonal_note(token);
+                }
+                token = strtok(NULL, " \t\r\n");
+            }
+            if (token != NULL) {
+                fail("too many columns", token);
+            }
+
+            if (size + 1 + PSG_CHANNELS >= MAX_ROWS) {
+                fail("the song is too long", "");
+            }
+            rows[size++] = channels;
+            for (int channel = 0; channel < PSG_CHANNELS; channel++) {
+                if (channels & (1 << channel)) {
+                    rows[size++] = notes[channel];
+                }
+            }
+            count++;
+        }
+    }
+    fclose(input);
+
+    if (count == 0) {
+        fail("the song has no rows", "");
+    }
+    if (loop == size) {
+        fail("the loop point is after the last row", "");
+    }
+    rows[size++] = PSG_END;
+
+    /* write it all out as a header like the image ones */
+    FILE* output = fopen(argv[2], "w");
+    if (output == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
+    fprintf(output, "/*\n * %s\n * made by tools/mus2gba from %s, %d rows in %d bytes\n */\n\n",
+            argv[2], argv[1], count, size);
+    fprintf(output, "#include \"psg.h\"\n\n");
+
+    fprintf(output, "const unsigned char %s_rows[%d] = {", name, size);
+    for (int i = 0; i < size; i++) {
+        fprintf(output, "%s0x%02x%s", (i % 12) ? " " : "\n    ", rows[i], (i + 1 < size) ? "," : "");
+    }
+    fprintf(output, "\n};\n\n");
+
+    fprintf(output, "const unsigned char %s_wave[16] = {", name);
+    for (int i = 0; i < 16; i++) {
+        fprintf(output, "%s0x%02x%s", (i % 8) ? " " : "\n    ", shape[i], (i + 1 < 16) ? "," : "");
+    }
+    fprintf(output, "\n};\n\n");
+
+    fprintf(output, "const struct Song %s_song = {\n", name);
+    fprintf(output, "    %s_rows, %d,\n    %d,\n", name, loop, speed);
+    fprintf(output, "    {0x%04x, 0x%04x, 0x%04x, 0x%04x},\n",
+            envelopes[0], envelopes[1], envelopes[2], envelopes[3]);
+    fprintf(output, "    %s_wave\n};\n", name);
+    fclose(output);
+    return 0;
+}
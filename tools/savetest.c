@@ -0,0 +1,226 @@
+/*
+ * savetest.c
+ * checks save.c against power being cut partway through a write, using the
+ * file the host build keeps SRAM in - this runs on the computer doing the
+ * build:
+ *
+ *     cc -DHOST_BUILD -o savetest tools/savetest.c save.c replay.c
+ *     ./savetest
+ *
+ * for every number of bytes a record or replay can have got through before
+ * the power went, SRAM is saved to the file there and loaded back - a
+ * record must load as the last good one or the new one, and not the new one
+ * before its checksum is written, and a replay must load as the new one or
+ * not at all - it also checks that a record goes in the slot not holding
+ * the newest good one, and that a record or replay whose checksum is wrong
+ * is passed over
+ *
+ * it exits with 0 if every check passed and 1 if any failed
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "../save.h"
+#include "../replay.h"
+#include "../input.h"
+
+/* where SRAM is kept while it runs, deleted at the end */
+#define SRAM_FILE "savetest.sram"
+#define SRAM_SIZE 0x8000
+
+/* the slots as save.c lays them out, and a byte inside each one's data */
+#define SLOT_SIZE 256
+#define SLOT_DATA 20
+#define REPLAY_OFFSET 0x200
+#define REPLAY_DATA (REPLAY_OFFSET + 0x20)
+
+static int failures = 0;
+
+static void check(int passed, const char* what, int bytes) {
+    if (!passed) {
+        fprintf(stderr, "%s, after %d bytes\n", what, bytes);
+        failures++;
+    }
+}
+
+/* a record with a score to tell it apart */
+static struct SaveData record(unsigned int score) {
+    struct SaveData data;
+    memset(&data, 0, sizeof(data));
+    data.scores[0] = score;
+    data.sound = 1;
+    data.music = 0;
+    data.ghost = 1;
+    return data;
+}
+
+/* what the power going off and coming back on does - SRAM keeps what was
+ * written, everything in RAM is lost and the game loads again */
+static int power_cycle(struct SaveData* data) {
+    save_host_close();
+    save_host_open(SRAM_FILE);
+    return save_load(data);
+}
+
+/* copy SRAM from one file to another */
+static void copy_sram(const char* from, const char* to) {
+    static unsigned char bytes[SRAM_SIZE];
+    FILE* file = fopen(from, "rb");
+    size_t read = file ? fread(bytes, 1, SRAM_SIZE, file) : 0;
+    if (file) {
+        fclose(file);
+    }
+    file = fopen(to, "wb");
+    fwrite(bytes, 1, read, file);
+    fclose(file);
+}
+
+/* flip a byte of the SRAM file */
+static void spoil(unsigned int offset) {
+    FILE* file = fopen(SRAM_FILE, "r+b");
+    fseek(file, offset, SEEK_SET);
+    int byte = fgetc(file);
+    fseek(file, offset, SEEK_SET);
+    fputc(byte ^ 0xff, file);
+    fclose(file);
+}
+
+/* the number of bytes a whole record takes to write */
+static int record_size( ) {
+    int bytes = 0;
+    struct SaveData data = record(1);
+    save_begin(&data);
+    while (save_step(1)) {
+        bytes++;
+    }
+    return bytes + 1;
+}
+
+static void test_records( ) {
+    struct SaveData loaded;
+
+    /* nothing saved yet gives the defaults */
+    remove(SRAM_FILE);
+    save_host_open(SRAM_FILE);
+    check(save_load(&loaded) == 0 && loaded.scores[0] == 0 && loaded.sound == 1, "empty SRAM did not load defaults", 0);
+
+    /* the first record goes in slot 0 and the second in slot 1 */
+    struct SaveData first = record(100), second = record(200), third = record(300);
+    save_begin(&first);
+    save_flush();
+    check(power_cycle(&loaded) && loaded.scores[0] == 100, "the first record did not load", 0);
+    save_begin(&second);
+    save_flush();
+    check(power_cycle(&loaded) && loaded.scores[0] == 200, "the second record did not load", 0);
+    save_host_close();
+    copy_sram(SRAM_FILE, SRAM_FILE ".both");
+
+    /* the third record goes over the first, so cutting it off anywhere
+     * leaves the second */
+    save_host_open(SRAM_FILE);
+    save_load(&loaded);
+    int size = record_size();
+    for (int bytes = 0; bytes <= size; bytes++) {
+        copy_sram(SRAM_FILE ".both", SRAM_FILE);
+        save_host_open(SRAM_FILE);
+        save_load(&loaded);
+        save_begin(&third);
+        int busy = save_step(bytes);
+
+        int good = power_cycle(&loaded);
+        check(good && (loaded.scores[0] == 200 || loaded.scores[0] == 300),
+              "a cut record did not leave a good one", bytes);
+        check(busy || loaded.scores[0] == 300, "a finished record did not load", bytes);
+        check(bytes > size - 4 || loaded.scores[0] == 200, "a record loaded before its checksum was written", bytes);
+
+        /* finish it so the next one starts clean */
+        save_flush();
+    }
+
+    /* the second record is in slot 1 - spoiling it leaves the first, and
+     * spoiling both leaves the defaults */
+    copy_sram(SRAM_FILE ".both", SRAM_FILE);
+    spoil(SLOT_SIZE + SLOT_DATA);
+    save_host_open(SRAM_FILE);
+    check(save_load(&loaded) && loaded.scores[0] == 100, "a bad checksum was not passed over", 0);
+    spoil(SLOT_DATA);
+    save_host_open(SRAM_FILE);
+    check(save_load(&loaded) == 0 && loaded.scores[0] == 0, "two bad checksums did not load defaults", 0);
+
+    /* with the newer one spoiled the next record goes over it, not the
+     * good one */
+    copy_sram(SRAM_FILE ".both", SRAM_FILE);
+    spoil(SLOT_SIZE + SLOT_DATA);
+    save_host_open(SRAM_FILE);
+    save_load(&loaded);
+    save_begin(&third);
+    save_step(size / 2);
+    check(power_cycle(&loaded) && loaded.scores[0] == 100, "a record went over the only good one", size / 2);
+    save_flush();
+    remove(SRAM_FILE ".both");
+}
+
+static void test_replays( ) {
+    static unsigned char runs[1024], buffer[SAVE_REPLAY_CAPACITY];
+    struct Replay replay, loaded;
+    replay_record_start(&replay, runs, sizeof(runs), 1234);
+    for (int frame = 0; frame < 600; frame++) {
+        replay_record(&replay, (frame / 7) % 3 == 0 ? BUTTON_UP : 0);
+    }
+    replay.score = 75;
+
+    /* an older replay to go over, which has only the first half */
+    struct Replay older = replay;
+    older.seed = 99;
+    older.length /= 2;
+    remove(SRAM_FILE);
+    save_host_open(SRAM_FILE);
+    save_begin_replay(&older);
+    save_flush();
+    save_host_close();
+    copy_sram(SRAM_FILE, SRAM_FILE ".older");
+
+    save_host_open(SRAM_FILE);
+    int size = 0;
+    save_begin_replay(&replay);
+    while (save_step(1)) {
+        size++;
+    }
+    size++;
+
+    /* once a replay has started being written the one it is going over is
+     * never loaded, and the new one only once all of it is in SRAM */
+    for (int bytes = 0; bytes <= size; bytes++) {
+        copy_sram(SRAM_FILE ".older", SRAM_FILE);
+        save_host_open(SRAM_FILE);
+        save_begin_replay(&replay);
+        int busy = save_step(bytes);
+        save_host_close();
+        save_host_open(SRAM_FILE);
+        int good = save_load_replay(&loaded, buffer, sizeof(buffer));
+        check(busy || good, "a finished replay was not loaded", bytes);
+        check(!good || bytes == 0 || (loaded.seed == 1234 && loaded.score == 75 && loaded.length == replay.length &&
+                                      memcmp(buffer, runs, replay.length) == 0), "a cut replay was loaded", bytes);
+        save_flush();
+    }
+
+    /* nor is one with a spoiled run */
+    save_host_close();
+    spoil(REPLAY_DATA + replay.length / 2);
+    save_host_open(SRAM_FILE);
+    check(!save_load_replay(&loaded, buffer, sizeof(buffer)), "a replay with a bad checksum was loaded", size);
+    remove(SRAM_FILE ".older");
+}
+
+int main( ) {
+    test_records();
+    test_replays();
+    remove(SRAM_FILE);
+
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("every check passed\n");
+    return 0;
+}
@@ -0,0 +1,21 @@
+/*
+ * uppercase.h
+ * upper casing strings for the screen, the fast version in ARM assembly
+ * (uppercase.s) and plain C ones to check it against (uppercase_ref.c)
+ */
+
+#ifndef UPPERCASE_H
+#define UPPERCASE_H
+
+/* turn a string to upper case in place, a word at a time - it is in IWRAM,
+ * too far from ROM for a plain branch */
+#ifdef HOST_BUILD
+void uppercase(char* s);
+#else
+void uppercase(char* s) __attribute__((long_call));
+#endif
+
+/* the same, a byte at a time, which uppercase has to agree with */
+void uppercase_reference(char* s);
+
+#endif
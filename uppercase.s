@@ -1,27 +1,63 @@
-.global uppercase
-uppercase:
-    sub sp, sp, #12
-    str r4, [sp, #0]
-    str r5, [sp, #4]
-    str lr, [sp, #8]
-    mov r5, #0
-    mov r4, r0
-.top:
-    ldrb r1, [r4, r5]
-    cmp r1, #0
-    beq .done
-    b .toupper
-.done:
-    ldr r4, [sp, #0]
-    ldr r5, [sp, #4]
-    ldr lr, [sp, #8]
-    add sp, sp, #12
-    mov pc, lr
-.toupper:
-    mov r0, r1
-    bl toupper
-    strb r0, [r4, r5]
+@ uppercase.s
+@ turns a string to upper case in place, four letters at a time - this is
+@ ARM code in IWRAM so whole screens of text can be done without libc
 
-    add r5, r5, #1
-    b .top
+    .section .iwram, "ax", %progbits
+    .arm
+    .align 2
 
+@ void uppercase(char* s)
+@ bytes are done one at a time until s is word aligned, then a word at a
+@ time until one has the terminating zero in it, then the rest by bytes -
+@ for each word, a byte is lower case if its low 7 bits plus 0x1f carry into
+@ the top bit (at least 'a') and plus 0x05 do not (not past 'z') and its own
+@ top bit is clear, and those top bits shifted down to 0x20 are cleared
+    .global uppercase
+uppercase:
+    @ r0 is s, r4 is 0x01010101 and r5 and r6 are it times 0x1f and 0x05
+    stmfd sp!, {r4-r6}
+    mov r4, #0x01
+    orr r4, r4, r4, lsl #8
+    orr r4, r4, r4, lsl #16
+    rsb r5, r4, r4, lsl #5
+    add r6, r4, r4, lsl #2
+.upperLead:
+    tst r0, #3
+    beq .upperWords
+    ldrb r1, [r0]
+    cmp r1, #0
+    beq .upperDone
+    sub r2, r1, #'a'
+    cmp r2, #25
+    subls r1, r1, #0x20
+    strb r1, [r0], #1
+    b .upperLead
+.upperWords:
+    ldr r1, [r0]
+    @ a zero byte borrows when 0x01 is taken away from it
+    sub r2, r1, r4
+    bic r2, r2, r1
+    tst r2, r4, lsl #7
+    bne .upperTail
+    @ the lower case bytes have 0x80 set in r3
+    bic r2, r1, r4, lsl #7
+    add r3, r2, r5
+    add r2, r2, r6
+    bic r3, r3, r2
+    bic r3, r3, r1
+    and r3, r3, r4, lsl #7
+    eor r1, r1, r3, lsr #2
+    str r1, [r0], #4
+    b .upperWords
+.upperTail:
+    ldrb r1, [r0]
+    cmp r1, #0
+    beq .upperDone
+    sub r2, r1, #'a'
+    cmp r2, #25
+    subls r1, r1, #0x20
+    strb r1, [r0], #1
+    b .upperTail
+.upperDone:
+    ldmfd sp!, {r4-r6}
+    bx lr
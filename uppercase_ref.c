@@ -0,0 +1,39 @@
+/*
+ * uppercase_ref.c
+ * plain C versions of uppercase.s, to check it against and for host builds
+ * which cannot run ARM code
+ */
+
+#include "uppercase.h"
+
+/* the same, a byte at a time, which uppercase has to agree with */
+void uppercase_reference(char* s) {
+    for (; *s; s++) {
+        if ((unsigned char) (*s - 'a') <= 'z' - 'a') {
+            *s -= 'a' - 'A';
+        }
+    }
+}
+
+#ifdef HOST_BUILD
+/* the same word at a time trick as uppercase.s, step for step */
+void uppercase(char* s) {
+    const unsigned int ones = 0x01010101;
+    for (; (unsigned long) s & 3; s++) {
+        if (*s == 0) {
+            return;
+        }
+        if ((unsigned char) (*s - 'a') <= 'z' - 'a') {
+            *s -= 'a' - 'A';
+        }
+    }
+
+    unsigned int* word = (unsigned int*) s;
+    while (!((*word - ones) & ~*word & (ones << 7))) {
+        unsigned int low = *word & ~(ones << 7);
+        unsigned int lower = (low + ones * 0x1f) & ~(low + ones * 0x05) & ~*word & (ones << 7);
+        *word++ ^= lower >> 2;
+    }
+    uppercase_reference((char*) word);
+}
+#endif
@@ -0,0 +1,203 @@
+/*
+ * vram.c
+ * a record of what is in each part of VRAM - every upload and every
+ * background's screen map claims the bytes it uses, so with VRAM_CHECK
+ * defined, anything written over something else still being shown is
+ * caught, and on the host the whole map can be printed
+ */
+
+#include <stddef.h>
+#include "vram.h"
+
+#ifdef HOST_BUILD
+#include <stdio.h>
+#include <string.h>
+#endif
+
+#if defined(VRAM_CHECK) || defined(HOST_BUILD)
+#define VRAM_KEEP
+#endif
+
+struct VramCheck vram_check = {0, NULL, NULL, VRAM_OBJ_TILES, 1};
+
+#ifdef VRAM_KEEP
+/* the claims, in the order they were made */
+static struct VramRegion regions[VRAM_MAX_REGIONS];
+static int count = 0;
+
+/* names are usually the same string, but compare them all the way */
+static int vram_same(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+/* note something running over something else, keeping the first one */
+static void vram_overlap(const char* first, const char* second) {
+    if (vram_check.overlaps++ == 0) {
+        vram_check.first = first;
+        vram_check.second = second;
+    }
+}
+#endif
+
+/* forget every claim */
+void vram_clear( ) {
+#ifdef VRAM_KEEP
+    count = 0;
+#endif
+    vram_check.overlaps = 0;
+    vram_check.first = NULL;
+    vram_check.second = NULL;
+}
+
+/* claim some bytes of VRAM, noting whether they are a screen map */
+static int vram_add(unsigned int start, unsigned int size, const char* name, int map) {
+#ifdef VRAM_KEEP
+    vram_release(name);
+
+    int fits = 1;
+    if (start + size > VRAM_SIZE) {
+        vram_overlap(name, "the end of VRAM");
+        fits = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        if (start < regions[i].start + regions[i].size && regions[i].start < start + size) {
+            vram_overlap(name, regions[i].name);
+            fits = 0;
+        }
+    }
+
+    if (count < VRAM_MAX_REGIONS) {
+        regions[count].start = start;
+        regions[count].size = size;
+        regions[count].name = name;
+        regions[count].map = map;
+        count++;
+    }
+    return fits;
+#else
+    (void) start;
+    (void) size;
+    (void) name;
+    (void) map;
+    return 1;
+#endif
+}
+
+/* claim some bytes of VRAM, taking over any claim of the same name -
+ * returns 0 if they run over someone else's or off the end of VRAM */
+int vram_claim(unsigned int start, unsigned int size, const char* name) {
+    return vram_add(start, size, name, 0);
+}
+
+/* claim the screen map a background control setting points at - 256x256
+ * is one screen block, 512 wide or high two and 512x512 four */
+int vram_claim_map(unsigned short control, const char* name) {
+    static const unsigned char blocks[4] = {1, 2, 2, 4};
+    unsigned int start = ((control >> 8) & 0x1f) * VRAM_SCREEN_BLOCK_SIZE;
+    return vram_add(start, blocks[control >> 14] * VRAM_SCREEN_BLOCK_SIZE, name, 1);
+}
+
+/* check that something other than a screen map was claimed over the first
+ * tile of the char block a background control setting points at */
+int vram_check_tiles(unsigned short control, const char* name) {
+#ifdef VRAM_KEEP
+    unsigned int base = ((control >> 2) & 3) * VRAM_CHAR_BLOCK_SIZE;
+    for (int i = 0; i < count; i++) {
+        if (!regions[i].map && regions[i].start <= base && base < regions[i].start + regions[i].size) {
+            return 1;
+        }
+    }
+    vram_overlap(name, "an empty char block");
+    return 0;
+#else
+    (void) control;
+    (void) name;
+    return 1;
+#endif
+}
+
+/* the sprite tiles start after the frame buffers in modes 3 to 5, which
+ * are claimed, and bit 6 picks 1D mapping over 2D */
+unsigned int vram_use_objects(unsigned int display_control) {
+    int mode = display_control & 7;
+    vram_check.obj_tiles = mode >= 3 ? VRAM_OBJ_TILES_BITMAP : VRAM_OBJ_TILES;
+    vram_check.obj_1d = (display_control >> 6) & 1;
+    if (mode >= 3) {
+        vram_claim(0, VRAM_OBJ_TILES_BITMAP, "frame buffers");
+    } else {
+        vram_release("frame buffers");
+    }
+    return vram_check.obj_tiles;
+}
+
+/* give up a claim, keeping the rest in order */
+void vram_release(const char* name) {
+#ifdef VRAM_KEEP
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        if (!vram_same(regions[i].name, name)) {
+            regions[kept++] = regions[i];
+        }
+    }
+    count = kept;
+#else
+    (void) name;
+#endif
+}
+
+#ifdef HOST_BUILD
+/* print every claim and the gaps between them, block by block - a claim
+ * is listed under each char block it touches */
+void vram_report( ) {
+    printf("VRAM, %d claims, %d overlapping, sprite tiles from 0x%05x in %s mapping\n", count,
+           vram_check.overlaps, vram_check.obj_tiles, vram_check.obj_1d ? "1D" : "2D");
+    for (int block = 0; block < VRAM_SIZE / VRAM_CHAR_BLOCK_SIZE; block++) {
+        unsigned int block_start = block * VRAM_CHAR_BLOCK_SIZE;
+        unsigned int block_end = block_start + VRAM_CHAR_BLOCK_SIZE;
+        if (block_start >= vram_check.obj_tiles) {
+            printf("sprite tiles (0x%05x)\n", block_start);
+        } else if (block < 4) {
+            printf("char block %d (0x%05x), screen blocks %d to %d\n", block, block_start,
+                   block * 8, block * 8 + 7);
+        } else {
+            printf("frame buffers (0x%05x)\n", block_start);
+        }
+
+        /* the claims touching this block in address order, with the gaps
+         * between them, and any starting inside the one before marked */
+        const struct VramRegion* sorted[VRAM_MAX_REGIONS];
+        int touching = 0;
+        for (int i = 0; i < count; i++) {
+            const struct VramRegion* region = &regions[i];
+            if (region->start < block_end && region->start + region->size > block_start) {
+                int j = touching++;
+                for (; j > 0 && sorted[j - 1]->start > region->start; j--) {
+                    sorted[j] = sorted[j - 1];
+                }
+                sorted[j] = region;
+            }
+        }
+        unsigned int covered = block_start;
+        for (int i = 0; i < touching; i++) {
+            const struct VramRegion* region = sorted[i];
+            unsigned int end = region->start + region->size;
+            if (region->start > covered) {
+                printf("    0x%05x-0x%05x %6u bytes free\n", covered, region->start - 1, region->start - covered);
+            }
+            printf("    0x%05x-0x%05x %6u bytes %s%s\n", region->start, end - 1, region->size, region->name,
+                   i > 0 && region->start < covered ? ", OVERLAPPING" : "");
+            covered = end > covered ? end : covered;
+        }
+        if (covered < block_end) {
+            printf("    0x%05x-0x%05x %6u bytes free\n", covered, block_end - 1, block_end - covered);
+        }
+    }
+    if (vram_check.overlaps) {
+        printf("%s first ran over %s\n", vram_check.first, vram_check.second);
+    }
+}
+#endif
@@ -0,0 +1,78 @@
+/*
+ * vram.h
+ * a record of what is in each part of VRAM - every upload and every
+ * background's screen map claims the bytes it uses, so with VRAM_CHECK
+ * defined, anything written over something else still being shown is
+ * caught, and on the host the whole map can be printed
+ *
+ * without VRAM_CHECK or HOST_BUILD nothing is kept and claims cost nothing
+ */
+
+#ifndef VRAM_H
+#define VRAM_H
+
+/* the 96K of VRAM, and how the tiled modes split it */
+#define VRAM_SIZE 0x18000
+#define VRAM_CHAR_BLOCK_SIZE 0x4000
+#define VRAM_SCREEN_BLOCK_SIZE 0x800
+
+/* where sprite tile 0 is, and where the sprite tiles start in the bitmap
+ * modes, whose frame buffers take the first 80K and so tiles 0 to 511 */
+#define VRAM_OBJ_TILES 0x10000
+#define VRAM_OBJ_TILES_BITMAP 0x14000
+
+/* the most claims kept at once */
+#define VRAM_MAX_REGIONS 32
+
+/* a claim, from an offset into VRAM, and who made it - map is set for a
+ * background's screen map, which never counts as its tiles */
+struct VramRegion {
+    unsigned int start;
+    unsigned int size;
+    const char* name;
+    int map;
+};
+
+/* what the checks have found, kept where a debugger can read it - the
+ * number of claims which ran over another or backgrounds pointing at char
+ * blocks nothing was put in, and the first two names involved - along with
+ * where the sprite tiles start and whether they are mapped in 1D */
+struct VramCheck {
+    int overlaps;
+    const char* first;
+    const char* second;
+    unsigned int obj_tiles;
+    int obj_1d;
+};
+extern struct VramCheck vram_check;
+
+/* forget every claim */
+void vram_clear( );
+
+/* claim some bytes of VRAM, taking over any claim of the same name -
+ * returns 0 if they run over someone else's or off the end of VRAM */
+int vram_claim(unsigned int start, unsigned int size, const char* name);
+
+/* claim the screen map a background control setting points at, which is
+ * one to four screen blocks depending on its size */
+int vram_claim_map(unsigned short control, const char* name);
+
+/* check that tiles were claimed at the start of the char block a
+ * background control setting points at - returns 0, counting it with the
+ * overlaps, if nothing but screen maps is there */
+int vram_check_tiles(unsigned short control, const char* name);
+
+/* take where the sprite tiles start and their mapping from the display
+ * control setting - in the bitmap modes the frame buffers are claimed too -
+ * returns the offset of the sprite tiles */
+unsigned int vram_use_objects(unsigned int display_control);
+
+/* give up a claim, when whatever it held is not shown any more */
+void vram_release(const char* name);
+
+#ifdef HOST_BUILD
+/* print every claim and the gaps between them, block by block */
+void vram_report( );
+#endif
+
+#endif
@@ -2,9 +2,9 @@
 @function to set the wall to move
 .global wallLeft
 wallLeft:
-	@r0 is curent x r1 is origx
-	cmp r0, #0
-	beq .moveBack
+	@r0 is curent x r1 is origx r2 is the x it goes back at
+	cmp r0, r2
+	ble .moveBack
 	sub r0, r0, #1
 	b .done
 	